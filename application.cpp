@@ -0,0 +1,1632 @@
+#include "application.h"
+#include "webgpu-utils.h"
+#include "readback-service.h"
+#include "upload-belt.h"
+#include "render-bundle-cache.h"
+#include "instance-culling.h"
+#include "meshlet-culling.h"
+#include "depth-pyramid.h"
+#include "draw-sort.h"
+#include "draw-queue.h"
+#include "pipeline-cache.h"
+#include "pipeline-compiler.h"
+#include "shader-reflection.h"
+#include "file-watcher.h"
+#include "mesh-optimizer.h"
+#include "mesh-file.h"
+#include "mesh-importer.h"
+#ifdef WEBGPU_BACKEND_WGPU
+    #include <webgpu/wgpu.h>
+#endif // WEBGPU_BACKEND_WGPU
+
+#include <glfw3webgpu.h>
+
+#ifdef __EMSCRIPTEN__
+#  include <emscripten.h>
+#endif
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "resources"
+#endif
+
+
+namespace {
+
+const char* kQuadShaderFile = "shader.wgsl";
+
+// 实例的动画与 GPU 剔除都按边长 1 的正方形算（外接圆半径 0.7071），导入的网格等比缩放、居中到 [-0.5, 0.5] 的 xy 范围内
+void fitToUnitQuad(Mesh& mesh) {
+    if (mesh.vertices.empty()) {
+        return;
+    }
+    float lower[2] = { mesh.vertices[0].position[0], mesh.vertices[0].position[1] };
+    float upper[2] = { lower[0], lower[1] };
+    for (const Mesh::Vertex& vertex : mesh.vertices) {
+        for (uint32_t axis = 0; axis < 2; ++axis) {
+            lower[axis] = std::min(lower[axis], vertex.position[axis]);
+            upper[axis] = std::max(upper[axis], vertex.position[axis]);
+        }
+    }
+    float extent = std::max(upper[0] - lower[0], upper[1] - lower[1]);
+    float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (Mesh::Vertex& vertex : mesh.vertices) {
+        for (uint32_t axis = 0; axis < 2; ++axis) {
+            vertex.position[axis] = (vertex.position[axis] - 0.5f * (lower[axis] + upper[axis])) * scale;
+        }
+    }
+}
+
+// LOD 误差的上限：网格已缩放到正方形的大小（边长 1），超过 5% 的简化就不要了
+const float kMaxLodError = 0.05f;
+
+// 热重载只换 pipeline，bind group 还是原来的：只比较 quad shader 用到的 buffer 绑定
+bool sameBufferEntries(const std::vector<wgpu::BindGroupLayoutEntry>& a, const std::vector<wgpu::BindGroupLayoutEntry>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].binding != b[i].binding || a[i].visibility != b[i].visibility
+            || a[i].buffer.type != b[i].buffer.type || a[i].buffer.hasDynamicOffset != b[i].buffer.hasDynamicOffset
+            || a[i].buffer.minBindingSize != b[i].buffer.minBindingSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// quad pipeline 的描述：descriptor 里的指针都指向这里的成员，所以不能拷贝
+struct Application::QuadPipelineDesc {
+    ShaderReflection::PackedVertexLayout vertexLayout;
+    ShaderReflection::PackedVertexLayout instanceLayout;
+    std::vector<wgpu::VertexBufferLayout> bufferLayouts;
+    std::vector<wgpu::ConstantEntry> constants;
+    wgpu::FragmentState fragmentState;
+    wgpu::BlendState blendState;
+    wgpu::ColorTargetState colorState;
+    wgpu::DepthStencilState depthStencilState;
+    std::vector<wgpu::BindGroupLayoutEntry> groupEntries;   // @group(0) 的布局，layout 由调用方给定
+    wgpu::RenderPipelineDescriptor descriptor;
+
+    QuadPipelineDesc() = default;
+    QuadPipelineDesc(const QuadPipelineDesc&) = delete;
+    QuadPipelineDesc& operator=(const QuadPipelineDesc&) = delete;
+};
+
+// 热重载在编译线程上准备的东西。module 不经 pipelineCache（缓存不是线程安全的），编译完成后随本对象释放
+struct Application::ShaderReload {
+    QuadPipelineDesc desc;
+    wgpu::ShaderModule shaderModule = nullptr;
+    std::vector<std::string> dependencies;  // 预处理读到的文件，完成后由渲染线程交给 shaderWatcher
+
+    ~ShaderReload() {
+        if (shaderModule != nullptr) {
+            shaderModule.release();
+        }
+    }
+};
+
+
+Application::Application() { }
+Application::Application(const ApplicationOptions& options) : options(options) { }
+Application::~Application() { }
+
+
+wgpu::RequiredLimits Application::GetRequiredLimits(wgpu::Adapter adapter) const {
+    wgpu::SupportedLimits supportedLimits;
+    adapter.getLimits(&supportedLimits);
+
+    wgpu::RequiredLimits requiredLimits = wgpu::Default;
+    requiredLimits.limits.maxVertexAttributes = 7;   // position + color，加上实例的 offset/scale/phase/depth/tint
+    requiredLimits.limits.maxVertexBuffers = 2;      // 顶点数据一个 VertexBuffer，实例数据一个
+    // 顶点/索引/uniform 都从 bufferPool 的大页里子分配，单个 buffer 最大就是一页
+    requiredLimits.limits.maxBufferSize = std::min(options.bufferPageSize, supportedLimits.limits.maxBufferSize);
+    if (options.maxBufferSize > requiredLimits.limits.maxBufferSize) {
+        requiredLimits.limits.maxBufferSize = std::min(options.maxBufferSize, supportedLimits.limits.maxBufferSize);
+    }
+    if (meshFile) {
+        // 超过一页的顶点/索引段单独占一个 buffer
+        uint64_t largestSection = std::max(meshFile->GetHeader().vertices.size, meshFile->GetHeader().indices.size);
+        requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize,
+                                                       std::min(largestSection, supportedLimits.limits.maxBufferSize));
+    }
+    if (importedMesh) {
+        // 导入的网格在这里还没压缩、没生成 LOD，按上限估：顶点按所选压缩格式，索引按 Uint32，
+        // 各级 LOD 拼在同一个 index buffer 里，每级都不比原网格多
+        uint64_t vertexSize = static_cast<uint64_t>(importedMesh->vertices.size()) * options.vertexEncoding.GetStride();
+        uint64_t indexSize = static_cast<uint64_t>(importedMesh->indices.size()) * sizeof(uint32_t) * std::max(options.lodLevels, 1u);
+        requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize,
+                                                       std::min(std::max(vertexSize, indexSize), supportedLimits.limits.maxBufferSize));
+    }
+    requiredLimits.limits.maxVertexBufferArrayStride = std::max<uint32_t>(options.vertexEncoding.GetStride(), sizeof(InstanceData)); // 顶点 stride 取决于压缩格式
+
+    requiredLimits.limits.maxInterStageShaderComponents = 3; // 从顶点着色器转发到片段着色器的数据最多为3个float，即rgb。
+    requiredLimits.limits.minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
+    requiredLimits.limits.minStorageBufferOffsetAlignment = supportedLimits.limits.minStorageBufferOffsetAlignment;
+
+    // 为uniform 配置limits
+    requiredLimits.limits.maxBindGroups = 1;
+    requiredLimits.limits.maxUniformBuffersPerShaderStage = 2; // 帧 uniform + 网格 uniform
+    requiredLimits.limits.maxUniformBufferBindingSize = 16 * 4;
+    // 每帧一份 uniform，用动态偏移在同一个 buffer 里切换
+    requiredLimits.limits.maxDynamicUniformBuffersPerPipelineLayout = 1;
+    uint64_t uniformBufferSize = static_cast<uint64_t>(GetUniformStride(supportedLimits.limits.minUniformBufferOffsetAlignment)) * options.framesInFlight;
+    requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize, uniformBufferSize);
+    // 实例很多时实例数据会单独占一页
+    uint64_t instanceBufferSize = static_cast<uint64_t>(std::max(options.instanceCount, 1u)) * sizeof(InstanceData);
+    requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize, std::min(instanceBufferSize, supportedLimits.limits.maxBufferSize));
+    if (options.gpuCulling) {
+        // 剔除用的 compute pass：读全部实例、写可见实例、写间接绘制参数，读深度金字塔；
+        // 生成深度金字塔的 compute pass：读深度缓冲 / 上一级，写这一级（8x8 的 workgroup，个数随窗口大小变）
+        requiredLimits.limits.maxStorageBuffersPerShaderStage = 3;
+        // 最大的 storage 绑定是实例数组或间接绘制参数（每级 LOD 最多 maxIndexSplits 段，.lwgm 以文件里的段数为准）
+        uint64_t maxLevelDraws = std::max(options.maxIndexSplits, 1u);
+        if (meshFile) {
+            maxLevelDraws = 1;
+            const MeshFileLod* fileLods = meshFile->GetLods();
+            for (uint32_t level = 0; level < meshFile->GetHeader().lodCount; ++level) {
+                maxLevelDraws = std::max<uint64_t>(maxLevelDraws, fileLods[level].submeshCount);
+            }
+        }
+        uint64_t storageBindingSize = std::max(instanceBufferSize, maxLevelDraws * InstanceCuller::kDrawArgsSize);
+        requiredLimits.limits.maxStorageBufferBindingSize = std::min(storageBindingSize, supportedLimits.limits.maxStorageBufferBindingSize);
+        requiredLimits.limits.maxSampledTexturesPerShaderStage = 1;
+        requiredLimits.limits.maxStorageTexturesPerShaderStage = 1;
+        requiredLimits.limits.maxComputeWorkgroupSizeX = 64;
+        requiredLimits.limits.maxComputeWorkgroupSizeY = 8;
+        requiredLimits.limits.maxComputeWorkgroupSizeZ = 1;
+        requiredLimits.limits.maxComputeInvocationsPerWorkgroup = 64;
+        requiredLimits.limits.maxComputeWorkgroupsPerDimension = supportedLimits.limits.maxComputeWorkgroupsPerDimension;
+    }
+    if (options.meshletCulling) {
+        // meshlet 剔除：三个 meshlet 数组、全部实例、输出索引、间接绘制参数；网格大时输出索引会超过一页，单独占一个 buffer
+        requiredLimits.limits.maxStorageBuffersPerShaderStage = 6;
+        requiredLimits.limits.maxStorageBufferBindingSize = supportedLimits.limits.maxStorageBufferBindingSize;
+        requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize,
+                                                       std::min(supportedLimits.limits.maxStorageBufferBindingSize, supportedLimits.limits.maxBufferSize));
+        requiredLimits.limits.maxComputeWorkgroupSizeX = 64;
+        requiredLimits.limits.maxComputeWorkgroupSizeY = 1;
+        requiredLimits.limits.maxComputeWorkgroupSizeZ = 1;
+        requiredLimits.limits.maxComputeInvocationsPerWorkgroup = 64;
+        requiredLimits.limits.maxComputeWorkgroupsPerDimension = supportedLimits.limits.maxComputeWorkgroupsPerDimension;
+    }
+    // 上传带的暂存 chunk
+    requiredLimits.limits.maxBufferSize = std::max(requiredLimits.limits.maxBufferSize, std::min(options.uploadChunkSize, supportedLimits.limits.maxBufferSize));
+    return requiredLimits;
+}
+
+uint32_t Application::GetUniformStride(uint32_t minUniformBufferOffsetAlignment) const {
+    uint32_t uniformSize = 4 * sizeof(float);
+    uint32_t alignment = std::max(minUniformBufferOffsetAlignment, 1u);
+    return (uniformSize + alignment - 1) / alignment * alignment;
+}
+
+
+void Application::InitializeBindGroups() {
+    std::vector<wgpu::BindGroupEntry> entries(2);
+    entries[0].binding = 0; // 对应 @binding(0)，这里不再是解释，而是直接赋值 bufUniform 的作用。
+    entries[0].buffer = bufUniform.buffer;
+    entries[0].offset = bufUniform.offset;   // 子分配的起点；每帧那一份的偏移在 setBindGroup 时作为动态偏移传入
+    entries[0].size = 4 * sizeof(float);
+    entries[1].binding = 1; // 网格的还原参数
+    entries[1].buffer = bufMeshUniform.buffer;
+    entries[1].offset = bufMeshUniform.offset;
+    entries[1].size = 8 * sizeof(float);
+
+    wgpu::BindGroupDescriptor descBindGroup{};
+    descBindGroup.layout = layoutBindGroup;
+    descBindGroup.entryCount = entries.size();
+    descBindGroup.entries = entries.data();
+    bindGroup = device.createBindGroup(descBindGroup);
+}
+
+void Application::BuildMesh(CompressedVertices& vertices, IndexBufferData& indexData, MeshletData& meshlets) {
+    Mesh mesh;
+    if (importedMesh) {
+        mesh = std::move(*importedMesh);
+    } else {
+        // 定义由两个三角形拼成的正方形的 点数据
+        mesh.vertices = {
+        //  x,    y,    z         r,   g,   b
+            { { -0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f } }, // 左下 0
+            { { +0.5f, -0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f } }, // 右下 1
+            { { +0.5f, +0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, // 右上 2
+            { { -0.5f, +0.5f, 0.0f }, { 1.0f, 1.0f, 0.0f } }  // 左上 3
+        };
+        // 定义索引，规则 点数据 如何组成三角形
+        mesh.indices = {
+            0, 1, 2, // 右下的三角形
+            0, 2, 3  // 左上的三角形
+        };
+    }
+
+    // 简化在优化之前：各级索引随后一起做顶点缓存优化、按 LOD 0 的引用顺序重排顶点
+    if (options.lodLevels > 1) {
+        buildLodChain(mesh, options.lodLevels, kMaxLodError);
+        if (!options.headless) {
+            std::cout << "LOD chain: " << mesh.indices.size() / 3 << " triangles";
+            for (const Mesh::Lod& lod : mesh.lods) {
+                std::cout << " -> " << lod.indices.size() / 3 << " (error " << lod.error << ")";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (options.optimizeMeshes) {
+        MeshOptimizationStats meshStats = optimizeMesh(mesh);
+        if (!options.headless) {
+            std::cout << "Mesh optimization: ACMR " << meshStats.acmrBefore << " -> " << meshStats.acmrAfter
+                      << ", " << meshStats.clusterCount << " clusters" << (meshStats.overdrawSorted ? " (overdraw sorted)" : "")
+                      << ", " << meshStats.removedVertices << " unused vertices removed" << std::endl;
+        }
+    }
+
+    // 顶点按 options.vertexEncoding 压缩，pipeline 的顶点布局用同样的格式
+    vertices = compressVertices(mesh, options.vertexEncoding);
+    // 顶点不多时用 Uint16 索引，否则切段或退回 Uint32；各级 LOD 依次拼在同一个 index buffer 里
+    std::vector<const std::vector<uint32_t>*> levels = { &mesh.indices };
+    for (const Mesh::Lod& lod : mesh.lods) {
+        levels.push_back(&lod.indices);
+    }
+    indexData = buildIndexBuffer(levels, static_cast<uint32_t>(mesh.vertices.size()), options.maxIndexSplits);
+    lods.clear();
+    for (uint32_t level = 0; level + 1 < indexData.levelFirstDraw.size(); ++level) {
+        lods.push_back(LodLevel{ indexData.levelFirstDraw[level], indexData.levelFirstDraw[level + 1] - indexData.levelFirstDraw[level],
+                                 level > 0 ? mesh.lods[level - 1].error : 0.0f });
+    }
+    // meshlet 在优化之后切：三角形已按顶点缓存排好，相邻三角形共享的顶点多，块更满
+    if (options.meshletCulling) {
+        meshlets = buildMeshlets(mesh, levels);
+        if (!options.headless) {
+            std::cout << "Meshlets: " << meshlets.meshlets.size() << " clusters, " << meshlets.vertices.size() << " vertex refs, "
+                      << meshlets.triangles.size() << " triangles" << std::endl;
+        }
+    }
+    if (!options.headless) {
+        std::cout << "Vertices: " << vertices.vertexCount << " x " << options.vertexEncoding.GetStride() << " bytes (float: "
+                  << 5 * sizeof(float) << "), max position error " << vertices.maxPositionError << std::endl;
+    }
+
+    if (!options.exportMeshFile.empty()) {
+        if (writeMeshFile(options.exportMeshFile, mesh, vertices, indexData)) {
+            std::cout << "Exported mesh to " << options.exportMeshFile << std::endl;
+        }
+    }
+}
+
+void Application::InitializeBuffers() {
+    // 几何数据：指定了 .lwgm 就把映射内存里的各段原样交给上传带，否则现场生成内置的正方形
+    CompressedVertices vertices;
+    IndexBufferData indexData;
+    MeshletData meshlets;
+    if (!meshFile) {
+        BuildMesh(vertices, indexData, meshlets);
+    }
+    const uint8_t* vertexBytes = meshFile ? meshFile->GetVertexData() : vertices.data.data();
+    uint64_t vertexSize = meshFile ? meshFile->GetHeader().vertices.size : vertices.data.size();
+    const uint8_t* indexBytes = meshFile ? meshFile->GetIndexData() : indexData.data.data();
+    uint64_t indexSize = meshFile ? meshFile->GetHeader().indices.size : indexData.data.size();
+    uint32_t totalIndexCount = meshFile ? meshFile->GetHeader().indexCount : indexData.indexCount;
+    Dequantization dequantization = meshFile ? meshFile->GetDequantization() : vertices.dequantization;
+    indexFormat = meshFile ? meshFile->GetIndexFormat() : indexData.format;
+    indexedDraws = meshFile ? meshFile->GetDraws() : indexData.draws;
+    if (meshFile) {
+        lods.clear();
+        const MeshFileLod* fileLods = meshFile->GetLods();
+        for (uint32_t level = 0; level < meshFile->GetHeader().lodCount; ++level) {
+            lods.push_back(LodLevel{ fileLods[level].firstSubmesh, fileLods[level].submeshCount, fileLods[level].error });
+        }
+    }
+    lods.resize(std::min<size_t>(lods.size(), std::max(options.lodLevels, 1u))); // 文件里的级数可能比要求的多
+    maxLodDraws = 1;
+    for (const LodLevel& lod : lods) {
+        maxLodDraws = std::max(maxLodDraws, lod.drawCount);
+    }
+    cullingLod = 0;
+    cullingDraws.assign(indexedDraws.begin() + lods[0].firstDraw, indexedDraws.begin() + lods[0].firstDraw + lods[0].drawCount);
+
+    // 不再每样数据各建一个 wgpu::Buffer，而是从同一个池子的大 buffer 里切：一个 buffer 同时带 Vertex/Index/Uniform 用途
+    // Storage : GPU 剔除只读的实例数据
+    bufferPool = std::make_unique<BufferSubAllocator>(device,
+        wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Index | wgpu::BufferUsage::Uniform
+        | wgpu::BufferUsage::Storage,
+        options.bufferPageSize, "Geometry & uniform pool");
+    // compute pass 写的数据另用一个池子：WebGPU 按整个 buffer 而不是按区间检查用途，
+    // 同一次 dispatch 里一个 buffer 作为 read_write storage 绑定时，不能再作为 uniform 或只读 storage 绑定
+    // Index : meshlet 剔除输出的索引
+    if (options.gpuCulling || options.meshletCulling) {
+        outputPool = std::make_unique<BufferSubAllocator>(device,
+            wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Index
+            | wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect,
+            options.bufferPageSize, "Culling output pool");
+    }
+
+    wgpu::SupportedLimits deviceLimits;
+    device.getLimits(&deviceLimits);
+
+    // 初始数据经上传带复制进池子，一次 submit 完成
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+
+    // 点数据：setVertexBuffer 的 offset 需 4 字节对齐；stride 总是 4 的倍数
+    bufPoint = bufferPool->Allocate(vertexSize, 4);
+    uploadBelt->Write(encoder, bufPoint.buffer, bufPoint.offset, vertexBytes, vertexSize);
+
+    // 还原量化位置用的 scale / offset，整个网格一份
+    bufMeshUniform = bufferPool->Allocate(8 * sizeof(float), deviceLimits.limits.minUniformBufferOffsetAlignment);
+    float* meshUniform = (float*)uploadBelt->Write(encoder, bufMeshUniform.buffer, bufMeshUniform.offset, 8 * sizeof(float));
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        meshUniform[axis] = dequantization.scale[axis];
+        meshUniform[4 + axis] = dequantization.offset[axis];
+    }
+    meshUniform[3] = meshUniform[7] = 0.0f;
+
+    // 索引：offset 需按索引格式对齐（4 字节对两种格式都够），data 已补齐到 4 的倍数
+    bufIndex = bufferPool->Allocate(indexSize, 4);
+    uploadBelt->Write(encoder, bufIndex.buffer, bufIndex.offset, indexBytes, indexSize);
+    if (!options.headless) {
+        std::cout << "Indices: " << totalIndexCount << " x " << (indexFormat == wgpu::IndexFormat::Uint16 ? "uint16" : "uint32")
+                  << " in " << indexedDraws.size() << " draw(s), " << lods.size() << " LOD(s)" << std::endl;
+    }
+
+    // 实例数据：先全部按 LOD 0 由近到远画，第一帧 UpdateLodSelection 再按屏幕大小分级
+    instances = GenerateInstances(std::max(options.instanceCount, 1u));
+    SortInstances(std::vector<uint32_t>(instances.size(), 0));
+    instanceCount = static_cast<uint32_t>(instances.size());
+    uint64_t instanceSize = instances.size() * sizeof(InstanceData);
+    lodInstanceCounts.assign(lods.size(), 0);
+    lodInstanceCounts[0] = instanceCount;
+    lodViewWidth = 0;
+    // 作为 storage 绑定时 offset 需按 minStorageBufferOffsetAlignment 对齐
+    uint32_t storageAlignment = deviceLimits.limits.minStorageBufferOffsetAlignment;
+    bufInstance = bufferPool->Allocate(instanceSize, options.gpuCulling || options.meshletCulling ? storageAlignment : 4);
+    uploadBelt->Write(encoder, bufInstance.buffer, bufInstance.offset, instances.data(), instanceSize);
+    if (options.gpuCulling) {
+        // 剔除后的实例与间接绘制参数，全部由 compute pass 每帧写入
+        bufVisibleInstance = outputPool->Allocate(instanceSize, storageAlignment);
+        bufDrawArgs = outputPool->Allocate(maxLodDraws * InstanceCuller::kDrawArgsSize, storageAlignment);
+    }
+    if (options.meshletCulling) {
+        // storage 绑定的大小不能为 0，空数组也占 4 字节
+        auto uploadStorage = [&](const void* data, uint64_t size) {
+            BufferAllocation allocation = bufferPool->Allocate(std::max<uint64_t>(size, 4), storageAlignment);
+            if (size > 0) {
+                uploadBelt->Write(encoder, allocation.buffer, allocation.offset, data, size);
+            }
+            return allocation;
+        };
+        bufMeshlets = uploadStorage(meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Meshlet));
+        bufMeshletVertices = uploadStorage(meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t));
+        bufMeshletTriangles = uploadStorage(meshlets.triangles.data(), meshlets.triangles.size() * sizeof(uint32_t));
+        // 剔除结果每帧由 compute pass 写入
+        bufMeshletIndices = outputPool->Allocate(std::max<uint64_t>(meshlets.maxLevelTriangles * 3ull * sizeof(uint32_t), 4), storageAlignment);
+        bufMeshletState = outputPool->Allocate(MeshletCuller::kStateSize, storageAlignment);
+        meshletLevelFirst = meshlets.levelFirstMeshlet;
+    }
+
+    // Uniform
+    // 每份 uniform 是 4 个 float (uniform buffer的size必须是16 bytes的倍数，虽然当前例子只使用一个f32)，
+    // 共 framesInFlight 份，每份的起点要对齐到 minUniformBufferOffsetAlignment，才能用作动态偏移
+    uniformStride = GetUniformStride(deviceLimits.limits.minUniformBufferOffsetAlignment);
+    bufUniform = bufferPool->Allocate(static_cast<uint64_t>(uniformStride) * options.framesInFlight,
+                                      deviceLimits.limits.minUniformBufferOffsetAlignment);
+
+    std::vector<FrameSlot>(options.framesInFlight).swap(frameSlots); // FrameSlot 含 atomic，不能拷贝/移动
+    for (uint32_t i = 0; i < options.framesInFlight; ++i) {
+        frameSlots[i].uniformOffset = i * uniformStride;
+        float* uniform = (float*)uploadBelt->Write(encoder, bufUniform.buffer, bufUniform.offset + frameSlots[i].uniformOffset, 4 * sizeof(float));
+        uniform[0] = 1.0f; // 先写入一个默认值吧...
+        uniform[1] = static_cast<float>(viewWidth) / static_cast<float>(viewHeight);
+        uniform[2] = uniform[3] = 0.0f;
+    }
+
+    uploadBelt->Finish();
+    wgpu::CommandBuffer command = encoder.finish(wgpu::Default);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+    uploadBelt->Recall();
+}
+
+
+std::vector<Application::InstanceData> Application::GenerateInstances(uint32_t count) const {
+    std::vector<InstanceData> instances(count);
+    if (count == 1) {
+        // 只有一个时与原来的单个正方形一模一样
+        instances[0] = { { 0.0f, 0.0f }, 1.0f, 0.0f, 0.5f, { 255, 255, 255, 255 } };
+        return instances;
+    }
+    // 每层铺成 cols x cols 的网格，每个正方形连同绕圈的半径（0.5 + orbitRadius）都留在自己的格子里。
+    // 第 l 层在深度 (l + 0.5) / layers 上，缩小到 1 / (1 + 2l)，与同一格子里第 0 层的正方形同相位转圈：
+    // 默认半径 0.3 时，转圈的偏差 0.3 * (1 - 1/3) 加上外接圆半径 0.7071 / 3 也不到半边长 0.5，始终被它完全挡住；
+    // --orbit 超过约 0.39 时第 1 层的边角会露出来
+    uint32_t layers = std::min(std::max(options.instanceLayers, 1u), count);
+    uint32_t perLayer = (count + layers - 1) / layers;
+    uint32_t cols = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(perLayer))));
+    float cell = 2.0f / static_cast<float>(cols);
+    float scale = cell / (2.0f * (0.5f + std::fabs(options.orbitRadius)));
+    for (uint32_t i = 0; i < count; ++i) {
+        InstanceData& instance = instances[i];
+        uint32_t layer = i / perLayer;
+        uint32_t c = i % perLayer;
+        instance.offset[0] = -1.0f + cell * (static_cast<float>(c % cols) + 0.5f);
+        instance.offset[1] = -1.0f + cell * (static_cast<float>(c / cols) + 0.5f);
+        instance.scale = scale / static_cast<float>(1 + 2 * layer);
+        instance.phase = 6.2831853f * std::fmod(static_cast<float>(c) * 0.618034f, 1.0f); // 黄金分割错开相位
+        instance.depth = (static_cast<float>(layer) + 0.5f) / static_cast<float>(layers);
+        uint32_t hash = (i + 1) * 2654435761u;
+        instance.color[0] = static_cast<uint8_t>(128 + ((hash >> 8) & 127));
+        instance.color[1] = static_cast<uint8_t>(128 + ((hash >> 16) & 127));
+        instance.color[2] = static_cast<uint8_t>(128 + ((hash >> 24) & 127));
+        instance.color[3] = 255;
+    }
+    return instances;
+}
+
+void Application::SortInstances(const std::vector<uint32_t>& levels) {
+    // 只有一个 pipeline，键里的 pipeline 恒为 0；material 是 LOD 级别，即用哪几段索引画
+    std::vector<DrawSortItem> items(instances.size());
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        items[i].key = packDrawSortKey(0, levels[i], instances[i].depth);
+        items[i].index = i;
+    }
+    radixSortDrawItems(items);
+    std::vector<InstanceData> sorted(instances.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        sorted[i] = instances[items[i].index];
+    }
+    instances.swap(sorted);
+}
+
+bool Application::InitializePipeline(wgpu::TextureFormat format) {
+    colorFormat = format;
+    shaderPreprocessor = std::make_unique<ShaderPreprocessor>(RESOURCE_DIR);
+    const ShaderReflection* reflection = nullptr;
+    wgpu::ShaderModule shaderModule = LoadShaderModule({}, "Quad shader", &reflection);
+    if (shaderModule == nullptr) {
+        return false;
+    }
+    // 占位 pipeline 是同一份源码的 PLACEHOLDER 变体：顶点布局与 bind group 完全一样，不做动画，编译几乎不花时间
+    wgpu::ShaderModule placeholderModule = nullptr;
+    if (options.asyncPipelineCompile) {
+        placeholderModule = LoadShaderModule({ { "PLACEHOLDER", "1" } }, "Placeholder shader");
+        if (placeholderModule == nullptr) {
+            return false;
+        }
+    }
+    return RequestPipeline(shaderModule, *reflection, placeholderModule);
+}
+
+wgpu::ShaderModule Application::LoadShaderModule(const ShaderPreprocessor::Defines& defines, const char* label,
+                                                 const ShaderReflection** reflection) {
+    std::string source;
+    if (!shaderPreprocessor->Process(kQuadShaderFile, defines, source)) {
+        std::cout << "Could not load shader " << ShaderPreprocessor::PermutationKey(kQuadShaderFile, defines) << std::endl;
+        return nullptr;
+    }
+    if (reflection != nullptr) {
+        *reflection = pipelineCache->GetShaderReflection(source);
+        if (*reflection == nullptr) {
+            return nullptr;
+        }
+    }
+    // 不同的 defines 可能展开成同样的源码，PipelineCache 按内容去重，只会创建一次
+    return CreateShaderModuleChecked(source, label);
+}
+
+void Application::WatchShaderDependencies() {
+    if (!shaderWatcher) {
+        return;
+    }
+    for (const std::string& path : shaderPreprocessor->GetDependencies()) {
+        shaderWatcher->Watch(path);
+    }
+}
+
+void Application::ReloadShaders() {
+    // 读文件、预处理、反射、创建 module 都放在编译线程上，渲染线程只提交，编译好了在 UpdatePendingPipeline 里换上。
+    // 出错就保留当前的 pipeline，改好再存一次即可
+    auto reload = std::make_shared<ShaderReload>();
+    wgpu::PipelineLayout layout = layoutPipeline;
+    std::vector<wgpu::BindGroupLayoutEntry> expectedEntries = bindGroupEntries;
+    std::cout << "Reloading " << kQuadShaderFile << std::endl;
+    pendingReload = reload;
+    pendingPipeline = pipelineCompiler->Compile("Quad pipeline",
+        [this, reload, layout, expectedEntries](wgpu::RenderPipelineDescriptor& descriptor) {
+            // 源码（含 include 的文件）可能都变了，用一个新的预处理器重新读、重新展开；shaderPreprocessor 只在渲染线程上用
+            ShaderPreprocessor preprocessor(RESOURCE_DIR);
+            std::string source;
+            bool processed = preprocessor.Process(kQuadShaderFile, {}, source);
+            reload->dependencies = preprocessor.GetDependencies(); // 可能新 include 了文件
+            if (!processed) {
+                std::cout << "Could not load shader " << kQuadShaderFile << std::endl;
+                return false;
+            }
+            ShaderReflection reflection;
+            if (!reflection.Parse(source)) {
+                return false;
+            }
+            // WGSL 有错时 module 是无效的，错误由 PipelineCompiler 记到这个 job 上
+            wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+            shaderCodeDesc.chain.next = nullptr;
+            shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+            shaderCodeDesc.code = source.c_str();
+            wgpu::ShaderModuleDescriptor shaderDesc;
+#ifdef WEBGPU_BACKEND_WGPU
+            shaderDesc.hintCount = 0;
+            shaderDesc.hints = nullptr;
+#endif
+            shaderDesc.label = "Quad shader";
+            shaderDesc.nextInChain = &shaderCodeDesc.chain;
+            reload->shaderModule = device.createShaderModule(shaderDesc);
+
+            if (!DescribePipeline(reload->shaderModule, reflection, reload->desc)) {
+                return false;
+            }
+            if (!sameBufferEntries(reload->desc.groupEntries, expectedEntries)) {
+                // 改了 binding：已有的 bind group 对不上新布局
+                std::cout << "Bind group layout changed, restart to apply" << std::endl;
+                return false;
+            }
+            reload->desc.descriptor.layout = layout;
+            descriptor = reload->desc.descriptor;
+            return true;
+        });
+}
+
+void Application::UpdateShaderHotReload() {
+    if (shaderWatcher && !shaderWatcher->TakeChanged().empty()) {
+        reloadRequested = true;
+    }
+    // 上一次的重载还没结束就先不动：一次只有一个 pendingPipeline
+    if (reloadRequested && !pendingPipeline) {
+        reloadRequested = false;
+        ReloadShaders();
+    }
+}
+
+wgpu::ShaderModule Application::CreateShaderModuleChecked(const std::string& source, const char* label) {
+    // createShaderModule 总会返回一个句柄，WGSL 错误只会报给错误回调，用错误作用域把它接住；
+    // 作用域是整个 device 共用的，期间不让后台线程编译 pipeline
+    std::unique_lock<std::mutex> scopeLock = pipelineCompiler->LockErrorScopes();
+    device.pushErrorScope(wgpu::ErrorFilter::Validation);
+    wgpu::ShaderModule shaderModule = pipelineCache->GetShaderModule(source, label);
+    if (!PopErrorScopeChecked("Shader compilation failed")) {
+        pipelineCache->EvictShaderModule(shaderModule); // 不让坏的 module 以后被当成命中
+        return nullptr;
+    }
+    return shaderModule;
+}
+
+bool Application::PopErrorScopeChecked(const char* what) {
+    bool done = false;
+    bool valid = true;
+    auto handle = device.popErrorScope([&done, &valid, what](wgpu::ErrorType type, char const* message) {
+        if (type != wgpu::ErrorType::NoError) {
+            std::cout << what << ": " << (message ? message : "") << std::endl;
+            valid = false;
+        }
+        done = true;
+    });
+    while (!done) {
+#if defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#elif defined(__EMSCRIPTEN__)
+        emscripten_sleep(1);
+#else
+        break; // wgpu-native 在 popErrorScope 里同步回调
+#endif
+    }
+    return valid;
+}
+
+bool Application::DescribePipeline(wgpu::ShaderModule shaderModule, const ShaderReflection& reflection, QuadPipelineDesc& desc) const {
+    wgpu::RenderPipelineDescriptor& pipelineDesc = desc.descriptor;
+
+    // 顶点布局由 vs_main 的参数反射出来：VertexInput 是每顶点的 buffer 0，InstanceInput 是每实例的 buffer 1，
+    // 属性按声明顺序紧凑排列。位置与颜色的格式取决于顶点压缩方式；tint 在 shader 里是 vec4f，buffer 里是 4 个字节
+    const ShaderReflection::EntryPoint* vertexEntry = reflection.FindEntryPoint("vs_main");
+    if (vertexEntry == nullptr || vertexEntry->inputs.size() != 2) {
+        std::cout << "vs_main should take a per-vertex and a per-instance input" << std::endl;
+        return false;
+    }
+    ShaderReflection::PackedVertexLayout& vertexLayout = desc.vertexLayout;
+    ShaderReflection::PackedVertexLayout& instanceLayout = desc.instanceLayout;
+    const VertexEncoding& encoding = options.vertexEncoding;
+    if (!reflection.PackVertexInput(vertexEntry->inputs[0], wgpu::VertexStepMode::Vertex, vertexLayout,
+                                    { { 0, encoding.GetPositionFormat() }, { 1, encoding.GetColorFormat() } })
+        || !reflection.PackVertexInput(vertexEntry->inputs[1], wgpu::VertexStepMode::Instance, instanceLayout,
+                                       { { 6, wgpu::VertexFormat::Unorm8x4 } })) {
+        return false;
+    }
+    // CPU 端的数据不是从反射生成的，核对一遍：顶点数据是 compressVertices 的输出，实例数据是 InstanceData
+    bool vertexMatches = vertexLayout.stride == encoding.GetStride()
+        && vertexLayout.OffsetOf("position") == 0 && vertexLayout.OffsetOf("color") == encoding.GetColorOffset();
+    bool instanceMatches = instanceLayout.stride == sizeof(InstanceData)
+        && instanceLayout.OffsetOf("offset") == static_cast<int64_t>(offsetof(InstanceData, offset))
+        && instanceLayout.OffsetOf("scale") == static_cast<int64_t>(offsetof(InstanceData, scale))
+        && instanceLayout.OffsetOf("phase") == static_cast<int64_t>(offsetof(InstanceData, phase))
+        && instanceLayout.OffsetOf("depth") == static_cast<int64_t>(offsetof(InstanceData, depth))
+        && instanceLayout.OffsetOf("tint") == static_cast<int64_t>(offsetof(InstanceData, color));
+    if (!vertexMatches || !instanceMatches) {
+        std::cout << "Shader vertex inputs do not match the CPU-side data, expected:" << std::endl
+                  << vertexLayout.Describe() << std::endl << instanceLayout.Describe() << std::endl;
+        return false;
+    }
+
+    desc.bufferLayouts = { vertexLayout.GetLayout(), instanceLayout.GetLayout() };
+    pipelineDesc.vertex.bufferCount = desc.bufferLayouts.size();
+    pipelineDesc.vertex.buffers = desc.bufferLayouts.data();
+
+    // 特化常量参与 PipelineCache 的 key，同样的取值再次请求时直接命中
+    desc.constants = GetSpecializationConstants();
+    pipelineDesc.vertex.module = shaderModule;
+    pipelineDesc.vertex.entryPoint = "vs_main";
+    pipelineDesc.vertex.constantCount = desc.constants.size();
+    pipelineDesc.vertex.constants = desc.constants.data();
+
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+
+    pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+    // meshlet 剔除按法线锥整块丢掉背面，光栅化也要丢掉剩下块里的背面三角形，否则画面取决于剔得多少
+    pipelineDesc.primitive.cullMode = options.meshletCulling ? wgpu::CullMode::Back : wgpu::CullMode::None;
+
+
+
+    wgpu::FragmentState& fragmentState = desc.fragmentState;
+    fragmentState.module = shaderModule;
+    fragmentState.entryPoint = "fs_main";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+
+    wgpu::BlendState& blendState = desc.blendState;
+    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blendState.color.operation = wgpu::BlendOperation::Add;
+    blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+    blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+    blendState.alpha.operation = wgpu::BlendOperation::Add;
+
+
+    wgpu::ColorTargetState& colorState = desc.colorState;
+    colorState.format = colorFormat;
+    colorState.blend = &blendState;
+    colorState.writeMask = wgpu::ColorWriteMask::All;
+
+
+    fragmentState.targetCount = 1;  // 因为count是1，对应 @location(0) 中的 0即为这里的colorState
+    fragmentState.targets = &colorState;
+    pipelineDesc.fragment = &fragmentState;
+
+    // 实例的深度由 vs_main 写进 position.z，近的挡住远的；不用模板
+    wgpu::DepthStencilState& depthStencilState = desc.depthStencilState;
+    depthStencilState = wgpu::Default; // 模板面默认 Always / Keep
+    depthStencilState.format = options.depthFormat;
+    depthStencilState.depthWriteEnabled = true;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+    depthStencilState.stencilReadMask = 0;
+    depthStencilState.stencilWriteMask = 0;
+    depthStencilState.depthBias = 0;
+    depthStencilState.depthBiasSlopeScale = 0.0f;
+    depthStencilState.depthBiasClamp = 0.0f;
+    pipelineDesc.depthStencil = options.depthFormat != wgpu::TextureFormat::Undefined ? &depthStencilState : nullptr;
+    pipelineDesc.multisample.count = 1;
+    pipelineDesc.multisample.mask = ~0u;
+    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+
+    // BindGroupLayoutEntry 也由反射得到：类型、minBindingSize、visibility 都来自 shader 里的 @group(0) 声明
+    desc.groupEntries = reflection.GetBindGroupLayoutEntries(0);
+    std::vector<wgpu::BindGroupLayoutEntry>& groupEntries = desc.groupEntries;
+    if (groupEntries.size() != 2 || groupEntries[0].buffer.type != wgpu::BufferBindingType::Uniform
+        || groupEntries[1].buffer.type != wgpu::BufferBindingType::Uniform) {
+        std::cout << "Quad shader should declare the view and mesh uniforms at @group(0) @binding(0..1)" << std::endl;
+        return false;
+    }
+    groupEntries[0].buffer.hasDynamicOffset = true; // shader 里看不出来：每帧通过动态偏移选用 bufUniform 中不同的一份
+
+    pipelineDesc.label = "Quad pipeline";
+    return true;
+}
+
+bool Application::RequestPipeline(wgpu::ShaderModule shaderModule, const ShaderReflection& reflection, wgpu::ShaderModule placeholderModule) {
+    // module / layout / pipeline 都从 pipelineCache 取，相同的描述不会重复编译；缓存拥有这些对象
+    QuadPipelineDesc desc;
+    if (!DescribePipeline(shaderModule, reflection, desc)) {
+        return false;
+    }
+    wgpu::RenderPipelineDescriptor& pipelineDesc = desc.descriptor;
+
+    wgpu::BindGroupLayoutDescriptor descGroupLayout{};
+    descGroupLayout.entryCount = desc.groupEntries.size();
+    descGroupLayout.entries = desc.groupEntries.data();
+    layoutBindGroup = pipelineCache->GetBindGroupLayout(descGroupLayout);
+    bindGroupEntries = desc.groupEntries;
+
+    // 创建 PipelineLayout
+    layoutPipeline = pipelineCache->GetPipelineLayout({ layoutBindGroup });
+
+
+    pipelineDesc.layout = layoutPipeline;
+    if (!options.asyncPipelineCompile) {
+        // 与 shader module 一样用错误作用域接住编译错误
+        std::unique_lock<std::mutex> scopeLock = pipelineCompiler->LockErrorScopes();
+        device.pushErrorScope(wgpu::ErrorFilter::Validation);
+        wgpu::RenderPipeline created = pipelineCache->GetRenderPipeline(pipelineDesc);
+        if (!PopErrorScopeChecked("Pipeline compilation failed")) {
+            pipelineCache->EvictRenderPipeline(created);
+            return false;
+        }
+        pipeline = created;
+        InvalidateRenderBundles(); // bundle 里录的是旧的 pipeline
+        return true;
+    }
+
+    pendingPipeline = pipelineCache->GetRenderPipelineAsync(pipelineDesc, *pipelineCompiler);
+    if (pendingPipeline->IsReady()) {
+        UpdatePendingPipeline(); // 缓存命中
+        return true;
+    }
+    if (placeholderModule == nullptr) {
+        return true;
+    }
+    // 编译完成之前 MainLoop 用占位 pipeline 继续出帧
+    pipelineDesc.label = "Placeholder pipeline";
+    pipelineDesc.vertex.module = placeholderModule;
+    pipelineDesc.vertex.constantCount = 0;  // 占位变体没有声明这些 override
+    pipelineDesc.vertex.constants = nullptr;
+    desc.fragmentState.module = placeholderModule;
+    pipeline = pipelineCache->GetRenderPipeline(pipelineDesc);
+    return true;
+}
+
+void Application::UpdatePendingPipeline() {
+    if (!pendingPipeline || !pendingPipeline->IsReady()) {
+        return;
+    }
+    if (pendingReload && shaderWatcher) {
+        // 编译失败也要监视：改好再存一次即可
+        for (const std::string& path : pendingReload->dependencies) {
+            shaderWatcher->Watch(path);
+        }
+    }
+    if (pendingPipeline->success) {
+        if (pendingReload) {
+            // 热重载的 pipeline 不在 pipelineCache 里，由这里持有到下一次替换
+            if (reloadedPipeline != nullptr) {
+                reloadedPipeline.release();
+            }
+            reloadedPipeline = pendingPipeline->pipeline;
+        }
+        pipeline = pendingPipeline->pipeline;
+        InvalidateRenderBundles(); // bundle 里录的是占位 pipeline
+        std::cout << "Pipeline '" << pendingPipeline->label << "' ready after "
+                  << pendingPipeline->compileMillis << " ms" << std::endl;
+    } else {
+        std::cout << "Pipeline '" << pendingPipeline->label << "' failed, keeping the current one" << std::endl;
+    }
+    pendingReload.reset();
+    pendingPipeline.reset();
+}
+
+void Application::InitializeOffscreenTarget(wgpu::TextureFormat format) {
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Offscreen render target";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.format = format;
+    textureDesc.size = { options.width, options.height, 1 };
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    // CopySrc : 以后可以把结果拷贝出来做截图/校验
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    offscreenTexture = device.createTexture(textureDesc);
+}
+
+void Application::InitializeDepthTarget() {
+    if (depthView != nullptr) {
+        depthView.release();
+        depthView = nullptr;
+    }
+    if (depthTexture != nullptr) {
+        depthTexture.destroy();
+        depthTexture.release();
+        depthTexture = nullptr;
+    }
+    if (options.depthFormat != wgpu::TextureFormat::Undefined) {
+        wgpu::TextureDescriptor textureDesc;
+        textureDesc.label = "Depth buffer";
+        textureDesc.dimension = wgpu::TextureDimension::_2D;
+        textureDesc.format = options.depthFormat;
+        textureDesc.size = { viewWidth, viewHeight, 1 };
+        textureDesc.mipLevelCount = 1;
+        textureDesc.sampleCount = 1;
+        // TextureBinding : 深度金字塔的第 0 级从这里读
+        textureDesc.usage = wgpu::TextureUsage::RenderAttachment;
+        if (depthPyramid && options.occlusionCulling) {
+            textureDesc.usage = textureDesc.usage | wgpu::TextureUsage::TextureBinding;
+        }
+        textureDesc.viewFormatCount = 0;
+        textureDesc.viewFormats = nullptr;
+        depthTexture = device.createTexture(textureDesc);
+
+        wgpu::TextureViewDescriptor viewDesc;
+        viewDesc.format = options.depthFormat;
+        viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+        viewDesc.baseMipLevel = 0;
+        viewDesc.mipLevelCount = 1;
+        viewDesc.baseArrayLayer = 0;
+        viewDesc.arrayLayerCount = 1;
+        viewDesc.aspect = wgpu::TextureAspect::DepthOnly;
+        depthView = depthTexture.createView(viewDesc);
+    }
+
+    if (depthPyramid) {
+        // 新的金字塔全是 1.0，重建后的第一帧不做遮挡剔除；不做遮挡剔除（或没有深度缓冲）时一直是 1.0
+        depthPyramid->Resize(options.occlusionCulling ? depthView : nullptr, viewWidth, viewHeight);
+        if (culler) {
+            culler->SetDepthPyramid(depthPyramid->GetView());
+        }
+    }
+}
+
+double Application::GetTime() const {
+    if (options.headless) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    return glfwGetTime();
+}
+
+wgpu::TextureView Application::GetNextSurfaceTextureView() {
+    wgpu::Texture texture = nullptr;
+    if (options.headless) {
+        // 没有 surface，每帧都画到同一张离屏纹理上
+        texture = offscreenTexture;
+    } else {
+        wgpu::SurfaceTexture surfaceTexture;
+        surface.getCurrentTexture(&surfaceTexture);
+        if (surfaceTexture.status != wgpu::SurfaceGetCurrentTextureStatus::Success) {
+            std::cout << "Failed to get current surface texture. Status: " << surfaceTexture.status << std::endl;
+            return nullptr;
+        }
+        texture = surfaceTexture.texture;
+    }
+
+    wgpu::TextureViewDescriptor tvDesc = {};
+    tvDesc.nextInChain = nullptr;
+    tvDesc.label = options.headless ? "Offscreen texture view" : "Surface texture view";
+    // tvDesc.format = wgpuTextureGetFormat(surfaceTexture.texture);
+    tvDesc.format = texture.getFormat();
+    // tvDesc.dimension = WGPUTextureViewDimension_2D;
+    tvDesc.dimension = wgpu::TextureViewDimension::_2D;
+    tvDesc.baseMipLevel = 0;
+    tvDesc.mipLevelCount = 1;
+    tvDesc.baseArrayLayer = 0;
+    tvDesc.arrayLayerCount = 1;
+    tvDesc.aspect = WGPUTextureAspect_All;
+    // WGPUTextureView targetView = wgpuTextureCreateView(surfaceTexture.texture, &tvDesc);
+    wgpu::TextureView targetView = texture.createView(tvDesc);
+    // wgpuTextureRelease(surfaceTexture.texture); // 释放纹理对象引用, 但wgpu-native不能手动释放，所以注释掉
+    return targetView;
+}
+
+// 初始化WebGPU和GLFW
+// 1. 初始化 glfw，输出 ： window (留存, IsRunning 判断)
+// 2. 实现化WGPUInstance : instance (销毁)
+// 3. window + instance 输出 WGPUSurface / surface (留存， 每次绘制时将渲染结果提交到屏幕显示)
+// 4. instance 请求出 WGPUAdapter / adapter (销毁)
+// 5. adapter 请求出 WGPUDevice / device (留存，创建CommandEncoder & 每次绘制时触发后端执行各种事件/回调)
+// 6. device 取出 WGPUQueue / queue (留存, 将渲染命令提交到GPU执行队列)
+// headless 模式跳过 1、3，第 4 步不指定 compatibleSurface，并用离屏纹理代替 surface
+bool Application::Initialize() {
+    startTime = std::chrono::steady_clock::now();
+    frameIndex = 0;
+    viewWidth = options.width;
+    viewHeight = options.height;
+    options.framesInFlight = std::min(std::max(options.framesInFlight, 1u), 3u);
+
+    if (!options.importFile.empty()) {
+        MeshImporter importer;
+        importedMesh = std::make_unique<Mesh>();
+        if (!importer.Import(options.importFile, *importedMesh)) {
+            return false;
+        }
+        const MeshImportStats& importStats = importer.GetStats();
+        std::cout << "-> Imported " << options.importFile << ": " << importStats.corners / 3 << " triangles, "
+                  << importStats.corners << " -> " << importStats.uniqueVertices << " vertices, " << importStats.chunks
+                  << " chunks parsed in " << importStats.parseMillis << " ms (" << importStats.totalMillis << " ms total)" << std::endl;
+        fitToUnitQuad(*importedMesh);
+    }
+
+    // 网格文件先映射：顶点格式跟随文件，device 的限制与 pipeline 的顶点布局都要用到
+    if (!options.meshFile.empty()) {
+        meshFile = std::make_unique<MappedMeshFile>();
+        if (!meshFile->Open(options.meshFile)) {
+            return false;
+        }
+        options.vertexEncoding = meshFile->GetVertexEncoding();
+        std::cout << "-> Mapped " << options.meshFile << ": " << meshFile->GetHeader().vertexCount << " vertices, "
+                  << meshFile->GetHeader().indexCount << " indices" << std::endl;
+        if (options.meshletCulling) {
+            // 包围球和法线锥要用未压缩的位置算，.lwgm 里只有压缩后的顶点
+            std::cout << "Meshlet culling needs the source mesh (--import), drawing " << options.meshFile << " without it" << std::endl;
+            options.meshletCulling = false;
+        }
+    }
+    if (options.meshletCulling && options.gpuCulling) {
+        // 两种剔除各自输出一份间接绘制参数，合不到一次 draw 里
+        std::cout << "--meshlets replaces --gpu-culling" << std::endl;
+        options.gpuCulling = false;
+    }
+    if (options.gpuCulling && options.occlusionCulling && options.depthFormat == wgpu::TextureFormat::Undefined) {
+        std::cout << "Occlusion culling needs a depth buffer, culling against the viewport only" << std::endl;
+        options.occlusionCulling = false;
+    }
+
+    if (!options.headless) {
+        // Init glfw Window
+        glfwInit();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE); // 宽高比走 uniform，缩放窗口只需重新配置 surface
+        window = glfwCreateWindow(options.width, options.height, "Learn WebGPU", nullptr, nullptr);
+        if (window == nullptr) {
+            std::cout << "Failed to create GLFW window." << std::endl;
+            return false;
+        }
+    }
+
+
+
+
+    wgpu::InstanceDescriptor desc = {};
+    wgpu::Instance instance = wgpu::createInstance(desc);    // wgpuInstanceRelease
+    if (instance == nullptr) {
+        std::cout << "Failed to create WebGPU instance." << std::endl;
+        return false;
+    }
+
+    std::cout << "-> Created WebGPU instance: " << instance << std::endl;
+
+    if (!options.headless) {
+        surface = glfwGetWGPUSurface(instance, window);         // wgpuSurfaceRelease
+        if (surface == nullptr) {
+            std::cout << "Failed to create WebGPU surface from GLFW window." << std::endl;
+            return false;
+        }
+        std::cout << "-> Created WebGPU surface: " << surface << std::endl;
+    }
+
+
+
+
+    wgpu::RequestAdapterOptions adapterOpts = {};
+    adapterOpts.nextInChain = nullptr;
+    adapterOpts.compatibleSurface = surface;    // 让适配器使用这个surface；headless 时为 nullptr，不要求能呈现
+    adapterOpts.forceFallbackAdapter = options.forceFallbackAdapter;
+    wgpu::Adapter adapter = instance.requestAdapter(adapterOpts);   // wgpuAdapterRelease
+    if (adapter == nullptr) {
+        std::cout << "-> Failed to get WebGPU adapter." << std::endl;
+        return false;
+    }
+    std::cout << "-> Got WebGPU adapter: " << adapter << std::endl;
+    inspectAdapter(adapter);
+
+    // wgpuInstanceRelease(instance); // 不再需要了,释放WGPUInstance
+    instance.release();
+
+    std::cout << "Requesting device ..." << std::endl;
+    wgpu::DeviceDescriptor deviceDesc = {};
+    deviceDesc.nextInChain = nullptr;
+    deviceDesc.label = "My WebGPU Device";
+    deviceDesc.requiredFeatureCount = 0;
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Default Queue";
+    deviceDesc.deviceLostCallback = [](WGPUDeviceLostReason reason, char const * message, void * ) {
+        std::cout << "WebGPU Device lost! Reason: " << reason << ", message: " << message << std::endl;
+    };
+    wgpu::RequiredLimits requiredLimits = GetRequiredLimits(adapter);
+    deviceDesc.requiredLimits = &requiredLimits;
+    
+    device = adapter.requestDevice(deviceDesc);       // wgpuDeviceRelease
+    if (device == nullptr) {
+        std::cout << "-> Failed to get WebGPU device." << std::endl;
+        return false;
+    }
+    std::cout << "-> Got WebGPU device: " << device << std::endl;
+    inspectDevice(device);
+
+    auto onDeviceError = [](wgpu::ErrorType type, char const * message) {
+        if (PipelineCompiler::CaptureError(type, message)) {
+            return; // 后台编译 pipeline 的错误，记在那个 job 上
+        }
+        std::cout << "WebGPU Device Error! Type: " << type << ", message: " << message << std::endl;
+    };
+    // wgpuDeviceSetUncapturedErrorCallback(device, onDeviceError, nullptr);
+    uncapturedErrorCallback = device.setUncapturedErrorCallback(onDeviceError);
+
+
+    // queue = wgpuDeviceGetQueue(device);     // wgpuQueueRelease
+    queue = device.getQueue();     // wgpuQueueRelease
+    std::cout << "-> Got WebGPU queue: " << queue << std::endl;
+
+    wgpu::TextureFormat textureFormat = wgpu::TextureFormat::RGBA8Unorm;
+    if (options.headless) {
+        InitializeOffscreenTarget(textureFormat);
+        std::cout << "-> Created offscreen target " << options.width << "x" << options.height << "." << std::endl;
+    } else {
+        wgpu::SurfaceConfiguration& cfgSurface = surfaceConfig;  // 留着，窗口缩放时改宽高重新 configure
+        cfgSurface.nextInChain = nullptr;
+        cfgSurface.device = device;
+        cfgSurface.width = options.width;
+        cfgSurface.height = options.height;
+        // cfgSurface.usage = WGPUTextureUsage_RenderAttachment;
+        cfgSurface.usage = wgpu::TextureUsage::RenderAttachment;
+        // WGPUTextureFormat textureFormat = wgpuSurfaceGetPreferredFormat(surface, adapter);
+        textureFormat = surface.getPreferredFormat(adapter);// Store the chosen surface format so pipeline creation can use it
+        cfgSurface.format = textureFormat;
+
+        cfgSurface.viewFormatCount = 0;
+        cfgSurface.viewFormats = nullptr;
+        cfgSurface.presentMode = WGPUPresentMode_Fifo;
+        cfgSurface.alphaMode = WGPUCompositeAlphaMode_Auto;
+        // wgpuSurfaceConfigure(surface, &cfgSurface);         // wgpuSurfaceUnconfigure2
+        surface.configure(cfgSurface);         // wgpuSurfaceUnconfigure
+        std::cout << "-> Configured WebGPU surface." << std::endl;
+    }
+    // 深度缓冲（与深度金字塔）跟着渲染目标的大小走，窗口缩放时与 surface 一起重建
+    if (options.gpuCulling) {
+        depthPyramid = std::make_unique<DepthPyramid>(device);
+        if (!depthPyramid->Initialize()) {
+            std::cout << "Could not initialize the depth pyramid!" << std::endl;
+            return false;
+        }
+    }
+    InitializeDepthTarget();
+
+
+    // wgpuAdapterRelease(adapter); // 不再需要了,释放WGPUAdapter
+    adapter.release(); // 不再需要了,释放WGPUAdapter
+
+
+    readback = std::make_unique<ReadbackService>(device, queue);
+    uploadBelt = std::make_unique<UploadBelt>(device, options.uploadChunkSize);
+    pipelineCache = std::make_unique<PipelineCache>(device);
+    pipelineCompiler = std::make_unique<PipelineCompiler>(device);
+    drawQueue = std::make_unique<DrawQueue>();
+
+    if (!InitializePipeline(textureFormat)) {
+        std::cout << "Could not initialize pipeline!" << std::endl;
+        return false;
+    }
+    if (options.hotReloadShaders) {
+        shaderWatcher = std::make_unique<FileWatcher>();
+        WatchShaderDependencies();
+        std::cout << "Watching " << RESOURCE_DIR << " for shader changes" << std::endl;
+    }
+    InitializeBuffers();
+    meshFile.reset(); // 已经复制进上传带，不再需要映射
+    importedMesh.reset();
+    InitializeBindGroups();
+
+    if (options.gpuCulling) {
+        culler = std::make_unique<InstanceCuller>(device);
+        if (!culler->Initialize(bufInstance, bufVisibleInstance, bufDrawArgs, bufUniform, instanceCount, sizeof(InstanceData),
+                                maxLodDraws, GetSpecializationConstants(), depthPyramid->GetView())) {
+            std::cout << "Could not initialize GPU culling!" << std::endl;
+            return false;
+        }
+    }
+
+    if (options.meshletCulling) {
+        meshletCuller = std::make_unique<MeshletCuller>(device);
+        if (!meshletCuller->Initialize(bufMeshlets, bufMeshletVertices, bufMeshletTriangles, bufInstance, bufMeshletIndices,
+                                       bufMeshletState, bufUniform, instanceCount, sizeof(InstanceData), GetSpecializationConstants())) {
+            std::cout << "Could not initialize meshlet culling!" << std::endl;
+            return false;
+        }
+    }
+
+    if (options.useRenderBundles) {
+        staticBundles = std::make_unique<RenderBundleCache>(device, "Static draws");
+        staticBundles->Configure(textureFormat, options.depthFormat, options.framesInFlight,
+            [this](wgpu::RenderBundleEncoder encoder, uint32_t variant) {
+                EncodeStaticDraws(encoder, frameSlots[variant].uniformOffset);
+            });
+    }
+    
+    // PlayingWithBuffers();
+    return true;
+}
+
+void Application::PlayingWithBuffers() {
+    const int LENGTH = 16;
+    // 预备cpu数据，准备写入到gpu
+    std::vector<uint8_t> numbers(LENGTH);
+    for (uint8_t i = 0; i < LENGTH; i ++) {
+        numbers[i] = i;
+    }
+
+
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Some GPU-side data buffer";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+    bufferDesc.size = LENGTH;
+    bufferDesc.mappedAtCreation = false;
+    // 1. 创建
+    wgpu::Buffer buffer1 = device.createBuffer(bufferDesc);
+
+    bufferDesc.label = "Output buffer";
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+    wgpu::Buffer buffer2 = device.createBuffer(bufferDesc);
+    // 2. 写入
+    queue.writeBuffer(buffer1, 0, numbers.data(), numbers.size());
+
+    // 3. 复制
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+    encoder.copyBufferToBuffer(buffer1, 0, buffer2, 0, LENGTH);
+    wgpu::CommandBuffer command = encoder.finish(wgpu::Default);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    // 4. 映射与读取
+    // 不再 `while (!ready) device.poll(true);` 空转：交给 ReadbackService，
+    // 它把 buffer2 复制到池子里的 MapRead 暂存 buffer，由 poll 线程推动 mapAsync 回调。
+    // 这里只是演示所以直接等 future；渲染循环里应改用回调形式，不阻塞。
+    ReadbackService::Result result = readback->ReadBuffer(buffer2, 0, LENGTH).get();
+    if (!result.success) {
+        std::cout << "buffer2 readback failed" << std::endl;
+    } else {
+        std::cout << "bufferData = [";
+        for (int i = 0; i < LENGTH; i++) {
+            std::cout << (int)result.data[i] << " ";
+        }
+        std::cout << "]" << std::endl;
+    }
+
+    // 5. 回收
+    buffer1.release();
+    buffer2.release();
+}
+
+void Application::Terminate() {
+    if (device != nullptr && queue != nullptr) {
+        // 等在途的帧执行完，fence 回调不会再访问已释放的 frameSlots
+        waitForQueueIdle(device, queue);
+    }
+    frameSlots.clear();
+    readback.reset(); // 会先交付完在途的回读
+    uploadBelt.reset();
+    staticBundles.reset(); // bundle 引用着 pipeline/buffer/bindGroup，先释放
+    culler.reset();
+    meshletCuller.reset();
+    depthPyramid.reset();
+    if (drawQueue) {
+        if (!options.headless) {
+            drawQueue->PrintStats();
+        }
+        drawQueue.reset();
+    }
+    if (depthView != nullptr) {
+        depthView.release();
+        depthView = nullptr;
+    }
+    if (depthTexture != nullptr) {
+        depthTexture.destroy();
+        depthTexture.release();
+        depthTexture = nullptr;
+    }
+    if (bindGroup != nullptr) {
+        bindGroup.release();
+        bindGroup = nullptr;
+    }
+    // pipeline 与 layout 归 pipelineCache 所有（热重载的除外）；compiler 先析构，等在途的编译完成
+    shaderWatcher.reset();
+    pipelineCompiler.reset();
+    if (pendingReload && pendingPipeline->success) {
+        pendingPipeline->pipeline.release(); // 编译好了但还没换上
+    }
+    pendingReload.reset();
+    pendingPipeline.reset();
+    if (reloadedPipeline != nullptr) {
+        reloadedPipeline.release();
+        reloadedPipeline = nullptr;
+    }
+    pipeline = nullptr;
+    layoutPipeline = nullptr;
+    layoutBindGroup = nullptr;
+    if (pipelineCache) {
+        if (!options.headless) {
+            pipelineCache->PrintStats();
+        }
+        pipelineCache.reset();
+    }
+    if (shaderPreprocessor) {
+        const ShaderPreprocessor::Stats& stats = shaderPreprocessor->GetStats();
+        if (!options.headless) {
+            std::cout << "Shader variants: " << stats.expansions << " expanded, " << stats.hits << " reused, "
+                      << stats.uniqueSources << " unique sources" << std::endl;
+        }
+        shaderPreprocessor.reset();
+    }
+    if (bufferPool) {
+        bufferPool->Free(bufUniform);
+        bufferPool->Free(bufMeshUniform);
+        bufferPool->Free(bufPoint);
+        bufferPool->Free(bufIndex);
+        bufferPool->Free(bufInstance);
+        bufferPool->Free(bufMeshlets);
+        bufferPool->Free(bufMeshletVertices);
+        bufferPool->Free(bufMeshletTriangles);
+        bufferPool.reset();
+    }
+    if (outputPool) {
+        outputPool->Free(bufVisibleInstance);
+        outputPool->Free(bufDrawArgs);
+        outputPool->Free(bufMeshletIndices);
+        outputPool->Free(bufMeshletState);
+        outputPool.reset();
+    }
+    if (queue != nullptr) {
+        // wgpuQueueRelease(queue);
+        queue.release();
+        queue = nullptr;
+    }
+    if (device != nullptr) {
+        // wgpuDeviceRelease(device);
+        device.release();
+        device = nullptr;
+    }
+    if (offscreenTexture != nullptr) {
+        offscreenTexture.destroy();
+        offscreenTexture.release();
+        offscreenTexture = nullptr;
+    }
+    if (surface != nullptr) {
+        // wgpuSurfaceUnconfigure(surface);
+        // wgpuSurfaceRelease(surface);
+        surface.unconfigure();
+        surface.release();
+        surface = nullptr;
+    }
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+        window = nullptr;
+    }
+    if (!options.headless) {
+        glfwTerminate();
+    }
+}
+
+template <typename Encoder>
+void Application::EncodeStaticDraws(Encoder encoder, uint32_t uniformOffset) {
+    // 每个 draw 带着完整的状态进队列，排序后重复的 setPipeline / setBindGroup / setVertexBuffer / setIndexBuffer 由队列省掉
+    DrawQueue::Draw draw;
+    draw.pipeline = pipeline;
+    draw.bindGroups[0].group = bindGroup;
+    draw.bindGroups[0].dynamicOffsetCount = 1;
+    draw.bindGroups[0].dynamicOffsets[0] = uniformOffset; // 动态偏移选中本帧那一份 uniform
+    draw.bindGroupCount = 1;
+    draw.vertexBuffers[0] = { bufPoint.buffer, bufPoint.offset, bufPoint.size };
+    // GPU 剔除时实例数由 compute pass 写进 bufDrawArgs，CPU 不需要知道
+    const BufferAllocation& instanceBuffer = culler ? bufVisibleInstance : bufInstance;
+    draw.vertexBuffers[1] = { instanceBuffer.buffer, instanceBuffer.offset, instanceBuffer.size };
+    draw.vertexBufferCount = 2;
+    if (meshletCuller) {
+        // 剔除后留下的三角形，索引已是网格顶点编号（Uint32，没有 baseVertex），所有实例一次画完
+        draw.indexBuffer = { bufMeshletIndices.buffer, bufMeshletIndices.offset, bufMeshletIndices.size };
+        draw.indexFormat = wgpu::IndexFormat::Uint32;
+        draw.indirectBuffer = bufMeshletState.buffer;
+        draw.indirectOffset = bufMeshletState.offset;
+        drawQueue->Enqueue(draw);
+        drawQueue->Submit(encoder);
+        return;
+    }
+    draw.indexBuffer = { bufIndex.buffer, bufIndex.offset, bufIndex.size };
+    draw.indexFormat = indexFormat;
+    if (culler) {
+        for (uint32_t i = 0; i < cullingDraws.size(); ++i) {
+            draw.indirectBuffer = bufDrawArgs.buffer;
+            draw.indirectOffset = bufDrawArgs.offset + i * InstanceCuller::kDrawArgsSize;
+            drawQueue->Enqueue(draw);
+        }
+        drawQueue->Submit(encoder);
+        return;
+    }
+    // 同一级 LOD 的实例在 bufInstance 里是连续的（级内由近到远），每级一次绘制，firstInstance 指到这一组的开头；
+    // 深度取这一组最近的实例，各组之间也由近到远提交
+    uint32_t firstInstance = 0;
+    for (uint32_t level = 0; level < lods.size(); ++level) {
+        uint32_t count = lodInstanceCounts[level];
+        if (count == 0) {
+            continue;
+        }
+        for (uint32_t i = lods[level].firstDraw; i < lods[level].firstDraw + lods[level].drawCount; ++i) {
+            const IndexedDraw& indexedDraw = indexedDraws[i];
+            draw.count = indexedDraw.indexCount;
+            draw.instanceCount = count;
+            draw.first = indexedDraw.firstIndex;
+            draw.baseVertex = indexedDraw.baseVertex;
+            draw.firstInstance = firstInstance;
+            draw.depth = instances[firstInstance].depth;
+            drawQueue->Enqueue(draw);
+        }
+        firstInstance += count;
+    }
+    drawQueue->Submit(encoder);
+}
+
+void Application::UpdateLodSelection(wgpu::CommandEncoder encoder) {
+    if (viewWidth == lodViewWidth || lods.size() < 2) {
+        return;
+    }
+    lodViewWidth = viewWidth;
+    // x 方向 NDC 的 [-1, 1] 对应整个视口宽度，网格的一个单位乘上实例缩放后占 scale * width / 2 像素
+    std::vector<uint32_t> levels(instances.size());
+    std::vector<uint32_t> counts(lods.size(), 0);
+    for (size_t i = 0; i < instances.size(); ++i) {
+        float pixelsPerUnit = instances[i].scale * static_cast<float>(viewWidth) * 0.5f;
+        levels[i] = selectLod(lods, pixelsPerUnit, options.lodPixelError);
+        ++counts[levels[i]];
+    }
+
+    if (culler || meshletCuller) {
+        // 剔除输出的是一个紧凑的可见实例列表 / 三角形列表，所有实例共用同一次绘制，只能整体选一级：取实例里最细的那一级
+        cullingLod = *std::min_element(levels.begin(), levels.end());
+        cullingDraws.assign(indexedDraws.begin() + lods[cullingLod].firstDraw,
+                            indexedDraws.begin() + lods[cullingLod].firstDraw + lods[cullingLod].drawCount);
+    } else if (counts != lodInstanceCounts) {
+        // 按级分组、级内由近到远；复制排在本帧的 render pass 之前，之前的帧在队列里先执行完
+        SortInstances(levels);
+        uploadBelt->Write(encoder, bufInstance.buffer, bufInstance.offset, instances.data(), instances.size() * sizeof(InstanceData));
+        lodInstanceCounts = counts;
+    } else {
+        return;
+    }
+    InvalidateRenderBundles(); // 每级的实例数 / 间接绘制的个数录在 bundle 里
+    if (!options.headless) {
+        std::cout << "LOD selection:";
+        for (uint32_t level = 0; level < lods.size(); ++level) {
+            std::cout << " " << counts[level];
+        }
+        std::cout << " instance(s) per level" << std::endl;
+    }
+}
+
+std::vector<wgpu::ConstantEntry> Application::GetSpecializationConstants() const {
+    std::vector<wgpu::ConstantEntry> constants(2);
+    constants[0].key = "orbitRadius";
+    constants[0].value = options.orbitRadius;
+    constants[1].key = "animate";
+    constants[1].value = options.animate ? 1.0 : 0.0;
+    return constants;
+}
+
+void Application::ResizeSurfaceIfNeeded() {
+    if (options.headless) {
+        return;
+    }
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    if (width <= 0 || height <= 0) {
+        return; // 最小化
+    }
+    if (static_cast<uint32_t>(width) == viewWidth && static_cast<uint32_t>(height) == viewHeight) {
+        return;
+    }
+    viewWidth = static_cast<uint32_t>(width);
+    viewHeight = static_cast<uint32_t>(height);
+    surfaceConfig.width = viewWidth;
+    surfaceConfig.height = viewHeight;
+    surface.configure(surfaceConfig);
+    InitializeDepthTarget();
+}
+
+void Application::InvalidateRenderBundles() {
+    if (staticBundles) {
+        staticBundles->Invalidate();
+    }
+    if (drawQueue) {
+        drawQueue->ResetIds(); // 旧 pipeline / buffer 的编号不再有用
+    }
+}
+
+void Application::MainLoop() {
+    if (!options.headless) {
+        glfwPollEvents();
+    }
+
+    ResizeSurfaceIfNeeded();
+
+	// Get the next target texture view
+	wgpu::TextureView targetView = GetNextSurfaceTextureView();
+	if (!targetView) return;
+
+    // shader 文件改了就在后台重新编译；编译好了就换掉当前（占位）pipeline
+    UpdateShaderHotReload();
+    UpdatePendingPipeline();
+
+    // 轮到的这一份 uniform 上一次被 framesInFlight 帧之前使用，通常早已执行完，不会等到上一帧
+    FrameSlot& slot = frameSlots[frameIndex % frameSlots.size()];
+    WaitForFrameSlot(slot);
+
+	// Create a command encoder for the draw call
+	// WGPUCommandEncoderDescriptor encoderDesc = {};
+	wgpu::CommandEncoderDescriptor encoderDesc = {};
+	encoderDesc.nextInChain = nullptr;
+	encoderDesc.label = "My command encoder";
+	// WGPUCommandEncoder cmdEncoder = wgpuDeviceCreateCommandEncoder(device, &encoderDesc);   // wgpuCommandEncoderRelease
+	wgpu::CommandEncoder cmdEncoder = device.createCommandEncoder(encoderDesc);   // wgpuCommandEncoderRelease
+
+    // 将时间与宽高比写入到 uniform buffer 中：直接写进上传带的映射内存，复制命令排在本帧 render pass 之前
+    float* uniform = (float*)uploadBelt->Write(cmdEncoder, bufUniform.buffer, bufUniform.offset + slot.uniformOffset, 4 * sizeof(float));
+    uniform[0] = static_cast<float>(GetTime());
+    uniform[1] = static_cast<float>(viewWidth) / static_cast<float>(viewHeight);
+    uniform[2] = uniform[3] = 0.0f;
+
+    // 视口宽度变了就重选各实例的 LOD（实例数据的复制同样排在 render pass 之前）
+    UpdateLodSelection(cmdEncoder);
+
+    // 剔除在 render pass 之前，生成本帧的间接绘制参数
+    if (culler) {
+        culler->Record(cmdEncoder, *uploadBelt, cullingDraws, slot.uniformOffset);
+    }
+    if (meshletCuller) {
+        uint32_t firstMeshlet = meshletLevelFirst[cullingLod];
+        meshletCuller->Record(cmdEncoder, *uploadBelt, firstMeshlet, meshletLevelFirst[cullingLod + 1] - firstMeshlet, slot.uniformOffset);
+    }
+
+	// Create the render pass that clears the screen with our color
+	// WGPURenderPassDescriptor renderPassDesc = {};
+    wgpu::RenderPassDescriptor renderPassDesc = {};
+	renderPassDesc.nextInChain = nullptr;
+
+	// The attachment part of the render pass descriptor describes the target texture of the pass
+	// WGPURenderPassColorAttachment colorAttachment = {};
+    wgpu::RenderPassColorAttachment colorAttachment = {};
+	colorAttachment.view = targetView;
+	colorAttachment.resolveTarget = nullptr;
+	colorAttachment.loadOp = WGPULoadOp_Clear;
+	colorAttachment.storeOp = WGPUStoreOp_Store;
+	// colorAttachment.clearValue = WGPUColor{ 1.0, 0.0, 1.0, 1.0 };
+	colorAttachment.clearValue = wgpu::Color{ 1.0, 0.0, 1.0, 1.0 };
+#ifndef WEBGPU_BACKEND_WGPU
+	renderPassColorAttachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
+#endif // NOT WEBGPU_BACKEND_WGPU
+
+	renderPassDesc.colorAttachmentCount = 1;
+	renderPassDesc.colorAttachments = &colorAttachment;
+
+    // 深度每帧清成最远；格式里没有模板，stencil 的 load/store 按各后端的要求填
+    wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
+    depthStencilAttachment.view = depthView;
+    depthStencilAttachment.depthClearValue = 1.0f;
+    depthStencilAttachment.depthLoadOp = wgpu::LoadOp::Clear;
+    depthStencilAttachment.depthStoreOp = wgpu::StoreOp::Store;
+    depthStencilAttachment.depthReadOnly = false;
+    depthStencilAttachment.stencilClearValue = 0;
+#ifdef WEBGPU_BACKEND_WGPU
+    depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Clear;
+    depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Store;
+#else
+    depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
+    depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
+#endif
+    depthStencilAttachment.stencilReadOnly = true;
+	renderPassDesc.depthStencilAttachment = depthView != nullptr ? &depthStencilAttachment : nullptr;
+	renderPassDesc.timestampWrites = nullptr;
+
+	// Create the render pass and end it immediately (we only clear the screen but do not draw anything)
+	// WGPURenderPassEncoder renderPass = wgpuCommandEncoderBeginRenderPass(cmdEncoder, &renderPassDesc);  // wgpuRenderPassEncoderRelease
+    // wgpuRenderPassEncoderEnd(renderPass);
+	// wgpuRenderPassEncoderRelease(renderPass);
+
+	wgpu::RenderPassEncoder renderPass = cmdEncoder.beginRenderPass(renderPassDesc);  // wgpuRenderPassEncoderRelease
+
+    if (staticBundles) {
+        // 录制好的命令直接回放；bundle 只在资源变化后的第一帧重录
+        wgpu::RenderBundle bundle = staticBundles->Get(static_cast<uint32_t>(frameIndex % frameSlots.size()));
+        renderPass.executeBundles(1, &bundle);
+    } else {
+        EncodeStaticDraws(renderPass, slot.uniformOffset);
+    }
+
+	renderPass.end();
+	renderPass.release();
+
+    // 本帧的深度生成金字塔，给下一帧的剔除用
+    if (depthPyramid) {
+        depthPyramid->Record(cmdEncoder);
+    }
+
+	// Finally encode and submit the render pass
+    uploadBelt->Finish(); // 本帧用到的暂存 chunk 必须在 submit 前 unmap
+	wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+	cmdBufferDescriptor.nextInChain = nullptr;
+	cmdBufferDescriptor.label = "Command buffer";
+	// WGPUCommandBuffer cmdBuffer = wgpuCommandEncoderFinish(cmdEncoder, &cmdBufferDescriptor); // wgpuCommandBufferRelease
+	// wgpuCommandEncoderRelease(cmdEncoder);
+    wgpu::CommandBuffer cmdBuffer = cmdEncoder.finish(cmdBufferDescriptor); // wgpuCommandBufferRelease
+	cmdEncoder.release();
+
+    // headless 下逐帧打印会成为瓶颈，影响吞吐量测量
+    if (!options.headless) {
+        std::cout << "Submitting command..." << std::endl;
+    }
+	// wgpuQueueSubmit(queue, 1, &cmdBuffer);
+	// wgpuCommandBufferRelease(cmdBuffer);
+#ifdef WEBGPU_BACKEND_WGPU
+    WGPUCommandBuffer rawCmdBuffer = cmdBuffer;
+    slot.submissionIndex = wgpuQueueSubmitForIndex(queue, 1, &rawCmdBuffer);
+#else
+    queue.submit(1, &cmdBuffer);
+#endif // WEBGPU_BACKEND_WGPU
+	cmdBuffer.release();
+    uploadBelt->Recall();
+    if (!options.headless) {
+        std::cout << "Command submitted." << std::endl;
+    }
+
+    // fence : 本帧之前提交的工作全部执行完时回调，这一份 uniform 才可以再写
+    slot.inFlight = true;
+    FrameSlot* pSlot = &slot; // frameSlots 初始化后不再改变大小，地址稳定
+    slot.fence = queue.onSubmittedWorkDone([pSlot](wgpu::QueueWorkDoneStatus) {
+        pSlot->inFlight = false;
+    });
+
+	// At the end of the frame
+	// wgpuTextureViewRelease(targetView);
+    targetView.release();
+#ifndef __EMSCRIPTEN__
+	// wgpuSurfacePresent(surface);
+    if (surface != nullptr) {
+        surface.present();
+    }
+#endif
+
+#if defined(WEBGPU_BACKEND_DAWN)
+	// wgpuDeviceTick(device);
+    device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+	// wgpuDevicePoll(device, false, nullptr);
+    // 不等待：headless 没有 vsync 节流，靠 frameSlots 限制 CPU 最多领先 framesInFlight 帧
+	device.poll(false);
+#endif
+    ++frameIndex;
+}
+
+void Application::WaitForFrameSlot(FrameSlot& slot) {
+    while (slot.inFlight) {
+#if defined(WEBGPU_BACKEND_WGPU)
+        // 只阻塞到这一份 uniform 所属的提交完成，不会连带等待更新的帧
+        WGPUWrappedSubmissionIndex index = {};
+        index.queue = queue;
+        index.submissionIndex = slot.submissionIndex;
+        wgpuDevicePoll(device, true, &index);
+#elif defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#else
+        break; // emscripten 由浏览器调度，无法在这里阻塞
+#endif
+    }
+}
+
+bool Application::IsRunning() {
+    if (options.headless) {
+        return options.frameCount == 0 || frameIndex < options.frameCount;
+    }
+    if (window == nullptr) {
+        return false;
+    }
+    bool b = glfwWindowShouldClose(window) == GLFW_FALSE;
+    return b;
+}
\ No newline at end of file
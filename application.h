@@ -0,0 +1,243 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <GLFW/glfw3.h>
+
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <string>
+
+#include "buffer-allocator.h"
+#include "pipeline-compiler.h"
+#include "shader-preprocessor.h"
+#include "vertex-compression.h"
+#include "index-buffer.h"
+#include "mesh-simplifier.h"
+#include "meshlet-builder.h"
+
+class ReadbackService;
+class UploadBelt;
+class RenderBundleCache;
+class InstanceCuller;
+class PipelineCache;
+class FileWatcher;
+class ShaderReflection;
+class MappedMeshFile;
+class MeshletCuller;
+class DepthPyramid;
+class DrawQueue;
+
+// 启动参数
+// headless : 不创建 GLFW 窗口和 surface，渲染到离屏 wgpu::Texture，没有 vsync/合成器的节流，
+//            用于在没有显示器（甚至没有 GPU）的 CI/渲染农场机器上测吞吐量。
+struct ApplicationOptions {
+    bool headless = false;
+    bool forceFallbackAdapter = false;  // 请求软件/回退适配器（lavapipe、WARP、SwiftShader 等）
+    uint32_t width = 800;
+    uint32_t height = 600;
+    uint32_t frameCount = 0;            // headless 下渲染多少帧后退出，0 表示一直运行
+    uint64_t maxBufferSize = 0;         // 额外申请的 maxBufferSize（如 bench 的大块上传），0 表示只按本例所需
+    uint32_t framesInFlight = 2;        // CPU 最多领先 GPU 几帧，2~3
+    uint64_t bufferPageSize = 4ull << 20; // 顶点/索引/uniform 子分配所用大 buffer 的页大小
+    uint64_t uploadChunkSize = 1ull << 20; // 上传带每个暂存 chunk 的大小
+    bool useRenderBundles = true;       // 静态绘制预录成 RenderBundle，每帧 executeBundles 回放
+    uint32_t instanceCount = 1;         // 正方形的实例个数，全部在一次 drawIndexed 里画完
+    uint32_t instanceLayers = 1;        // 实例分成几层叠在不同深度上，越靠后的层越小，藏在前一层的正方形后面
+    bool gpuCulling = false;            // compute pass 剔除视口外的实例，drawIndexedIndirect 绘制
+    bool occlusionCulling = true;       // gpuCulling 时再用上一帧的深度金字塔剔除被挡住的实例，需要深度缓冲
+    // 深度缓冲的格式，Undefined 表示不要深度缓冲（pipeline 不做深度测试，实例按提交顺序互相覆盖）
+    wgpu::TextureFormat depthFormat = wgpu::TextureFormat::Depth32Float;
+    bool asyncPipelineCompile = true;   // 渲染 pipeline 在后台编译，完成前用占位 pipeline 出帧
+    bool hotReloadShaders = false;      // 监视 resources/shader.wgsl，保存后在后台重编并替换 pipeline
+    // 特化常量：作为 override constants 在创建 pipeline 时给定，换一组取值就是另一个（被缓存的）pipeline
+    float orbitRadius = 0.3f;           // 正方形绕实例中心转圈的半径（乘以实例缩放）
+    bool animate = true;                // false 时正方形停在 phase 对应的位置
+    VertexEncoding vertexEncoding;      // 顶点上传前的压缩格式，默认 snorm16 位置 + unorm8 颜色
+    bool optimizeMeshes = true;         // 加载时做顶点缓存 / overdraw / 顶点读取顺序优化
+    uint32_t maxIndexSplits = 8;        // 顶点超过 65535 个时最多切成几段 Uint16 索引，再多就用 Uint32
+    std::string meshFile;               // 非空时从 .lwgm 文件 mmap 加载网格，代替内置的正方形；顶点格式以文件为准
+    std::string importFile;             // 非空时导入 .obj / .gltf / .glb 代替内置的正方形（缩放到正方形的大小）
+    std::string exportMeshFile;         // 非空时把处理好的内置网格写成 .lwgm
+    uint32_t lodLevels = 4;             // 加载时用 QEM 简化生成的 LOD 级数（含原网格），1 表示不生成
+    float lodPixelError = 1.0f;         // 允许的投影误差（像素），按它给每个实例选最粗的一级
+    bool meshletCulling = false;        // 网格切成 meshlet，compute pass 逐块做视口/背面剔除后再画；与 gpuCulling 二选一
+};
+
+class Application {
+public:
+    Application();
+    explicit Application(const ApplicationOptions& options);
+
+    ~Application();
+
+
+    bool Initialize();
+    void Terminate();
+    void MainLoop();
+    bool IsRunning();
+
+    // 供 bench 等复用初始化好的设备直接做测量
+    wgpu::Device GetDevice() const { return device; }
+    wgpu::Queue GetQueue() const { return queue; }
+    // 异步回读（计算结果、截图），不阻塞渲染线程
+    ReadbackService& GetReadbackService() { return *readback; }
+    // 管线缓存，bench 可读取命中统计
+    PipelineCache& GetPipelineCache() { return *pipelineCache; }
+    // headless 时的离屏渲染目标，可交给 ReadbackService::ReadTexture 截图
+    wgpu::Texture GetOffscreenTexture() const { return offscreenTexture; }
+    // pipeline / 顶点、索引 buffer / bindGroup 重建后调用，已录制的 RenderBundle 引用的是旧资源
+    void InvalidateRenderBundles();
+private:
+    wgpu::TextureView GetNextSurfaceTextureView();
+    // 从 RESOURCE_DIR 读取 shader 并创建 pipeline
+    bool InitializePipeline(wgpu::TextureFormat format);
+    struct QuadPipelineDesc;
+    struct ShaderReload;
+    // 用 shaderModule 及其反射填好 desc（不含 layout）。只读 options，热重载时在编译线程上调用。
+    // 反射出的布局与 CPU 端数据对不上时返回 false
+    bool DescribePipeline(wgpu::ShaderModule shaderModule, const ShaderReflection& reflection, QuadPipelineDesc& desc) const;
+    // 启动时用 shaderModule 组装 pipeline 描述并（异步）创建；给了 placeholderModule 时编译期间先用它的占位 pipeline
+    bool RequestPipeline(wgpu::ShaderModule shaderModule, const ShaderReflection& reflection, wgpu::ShaderModule placeholderModule);
+    // 异步编译的 pipeline 完成后替换掉当前（占位）pipeline
+    void UpdatePendingPipeline();
+    // WGSL 有错时返回 nullptr（用错误作用域捕获）
+    wgpu::ShaderModule CreateShaderModuleChecked(const std::string& source, const char* label);
+    // 弹出 pushErrorScope(Validation) 并等到结果，有错时打印 what 与错误信息并返回 false；调用方持有 LockErrorScopes
+    bool PopErrorScopeChecked(const char* what);
+    // vs_main 与剔除 shader 共用的 override constants
+    std::vector<wgpu::ConstantEntry> GetSpecializationConstants() const;
+    // 窗口大小变了就重新配置 surface；宽高比经由 uniform 传给 shader，pipeline 不用重建
+    void ResizeSurfaceIfNeeded();
+    // 预处理 quad shader 的一个变体并创建 module；给了 reflection 时一并取出反射结果。失败返回 nullptr
+    wgpu::ShaderModule LoadShaderModule(const ShaderPreprocessor::Defines& defines, const char* label,
+                                        const ShaderReflection** reflection = nullptr);
+    void WatchShaderDependencies();
+    // 把读文件到编译 pipeline 的整个重载过程交给 pipelineCompiler，结果由 UpdatePendingPipeline 换上
+    void ReloadShaders();
+    void UpdateShaderHotReload();
+    // 按实例在屏幕上的大小选 LOD，实例按级分组后重新上传；只在视口宽度变化时重算
+    void UpdateLodSelection(wgpu::CommandEncoder encoder);
+    // headless 模式下代替 surface 的离屏渲染目标
+    void InitializeOffscreenTarget(wgpu::TextureFormat format);
+    // 按 viewWidth x viewHeight （重新）创建深度缓冲，有深度金字塔时一并重建；与 surface 的配置一起调用
+    void InitializeDepthTarget();
+    // 秒；有窗口时用 glfwGetTime，headless 下 GLFW 未初始化，改用 steady_clock
+    double GetTime() const;
+
+    // 实现：创建 、 写入 、 复制 、 读取/映射 、 释放这些操作。
+    void PlayingWithBuffers();
+
+    // 因为要传入vertex positon,需要使用vertexBuffer，需要提前申请maxVertexBuffer
+    wgpu::RequiredLimits GetRequiredLimits(wgpu::Adapter adapter) const;
+    // 导入的网格或内置的正方形：优化、压缩顶点、生成索引（--export-mesh 时顺便写成 .lwgm）；meshletCulling 时再切 meshlet
+    void BuildMesh(CompressedVertices& vertices, IndexBufferData& indexData, MeshletData& meshlets);
+    void InitializeBuffers();
+    void InitializeBindGroups();
+
+    // 每个实例的数据，作为 stepMode = Instance 的第二个 vertex buffer
+    struct InstanceData {
+        float offset[2];        // 实例中心
+        float scale;
+        float phase;            // 绕圈动画的相位
+        float depth;            // 裁剪空间的 z，[0, 1]，越小越近
+        uint8_t color[4];       // unorm8x4，与顶点颜色相乘
+    };
+    // 1 个时就是原来居中的正方形；多个时每层铺满整个视口
+    std::vector<InstanceData> GenerateInstances(uint32_t count) const;
+    // instances 按 (LOD 级别, 深度) 的排序键重排：同一级的实例连续存放（一次 drawIndexed），级内由近到远，
+    // 先画的近处实例写下深度，后面被挡住的片段在深度测试里提前丢掉
+    void SortInstances(const std::vector<uint32_t>& levels);
+
+    // 每帧 uniform 的一份：bufUniform 里的动态偏移 + GPU 是否还在用它（onSubmittedWorkDone 充当 fence）
+    struct FrameSlot {
+        uint32_t uniformOffset = 0;
+        std::atomic<bool> inFlight{ false };
+        std::unique_ptr<wgpu::QueueOnSubmittedWorkDoneCallback> fence;
+#ifdef WEBGPU_BACKEND_WGPU
+        uint64_t submissionIndex = 0;   // WGPUSubmissionIndex，只等这一次提交
+#endif // WEBGPU_BACKEND_WGPU
+    };
+    // 阻塞到这一份 uniform 所属的那一帧在 GPU 上执行完（只等那一帧，不等之后的帧）
+    void WaitForFrameSlot(FrameSlot& slot);
+    // uniform 数据大小按 minUniformBufferOffsetAlignment 向上对齐后的步长
+    uint32_t GetUniformStride(uint32_t minUniformBufferOffsetAlignment) const;
+    // 静态几何的绘制命令，经 drawQueue 排序后编码；Encoder 为 RenderPassEncoder（直接编码）或 RenderBundleEncoder（预录）
+    template <typename Encoder>
+    void EncodeStaticDraws(Encoder encoder, uint32_t uniformOffset);
+private:
+    ApplicationOptions options;
+    std::chrono::steady_clock::time_point startTime;
+    uint32_t frameIndex = 0;
+
+    GLFWwindow* window = nullptr;
+    wgpu::Surface surface = nullptr;
+    wgpu::SurfaceConfiguration surfaceConfig = {};
+    uint32_t viewWidth = 0;                     // 当前渲染目标的大小
+    uint32_t viewHeight = 0;
+    wgpu::Texture offscreenTexture = nullptr;   // headless 时的渲染目标
+    wgpu::Texture depthTexture = nullptr;       // 与渲染目标一样大，随之重建
+    wgpu::TextureView depthView = nullptr;
+    wgpu::Device device = nullptr;
+    wgpu::Queue queue = nullptr;
+
+    std::unique_ptr<wgpu::ErrorCallback> uncapturedErrorCallback;
+    std::unique_ptr<ReadbackService> readback;
+    std::unique_ptr<UploadBelt> uploadBelt;     // 顶点/索引/uniform 的上传都经由它，代替 queue.writeBuffer
+
+    std::unique_ptr<PipelineCache> pipelineCache;
+    std::unique_ptr<PipelineCompiler> pipelineCompiler;
+    wgpu::RenderPipeline pipeline;      // 由 pipelineCache 持有，不要 release
+    PipelineCompiler::Handle pendingPipeline;   // 正在后台编译的正式 pipeline
+    std::shared_ptr<ShaderReload> pendingReload;    // pendingPipeline 是热重载时
+    wgpu::RenderPipeline reloadedPipeline;  // 当前热重载出的 pipeline，不在 pipelineCache 里，由这里 release
+    wgpu::TextureFormat colorFormat = wgpu::TextureFormat::Undefined;
+    std::unique_ptr<ShaderPreprocessor> shaderPreprocessor;
+    std::unique_ptr<FileWatcher> shaderWatcher;
+    bool reloadRequested = false;
+
+    // 顶点、索引、uniform 都是从 bufferPool 的大 buffer 里切出来的 (buffer, offset, size)
+    std::unique_ptr<BufferSubAllocator> bufferPool;
+    std::unique_ptr<MappedMeshFile> meshFile;   // 只在初始化期间映射
+    std::unique_ptr<Mesh> importedMesh;         // 同上，只在初始化期间持有
+    BufferAllocation bufPoint;
+    BufferAllocation bufIndex;
+    wgpu::IndexFormat indexFormat = wgpu::IndexFormat::Uint16;
+    std::vector<IndexedDraw> indexedDraws;  // 每段索引一次 drawIndexed，各级 LOD 依次排列
+    std::vector<LodLevel> lods;             // 每级 LOD 在 indexedDraws 里的范围，至少一级
+    BufferAllocation bufInstance;
+    uint32_t instanceCount = 1;
+    std::vector<InstanceData> instances;    // bufInstance 的 CPU 副本，按所选 LOD 分组排列
+    std::vector<uint32_t> lodInstanceCounts;    // 每级 LOD 画的实例数，bufInstance 里按级连续存放
+    uint32_t cullingLod = 0;                // GPU 剔除时所有实例共用的那一级 LOD
+    std::vector<IndexedDraw> cullingDraws;  // gpuCulling 时这一级的 draws
+    uint32_t maxLodDraws = 1;               // 各级 LOD 里最多的 draw 数，即 bufDrawArgs 的参数个数
+    uint32_t lodViewWidth = 0;              // 上次选 LOD 时的视口宽度
+    // gpuCulling 时：剔除后的实例 + DrawIndexedIndirect 参数，从 outputPool 分配
+    std::unique_ptr<BufferSubAllocator> outputPool; // compute pass 写入的数据，与 bufferPool 的只读数据分开
+    BufferAllocation bufVisibleInstance;
+    BufferAllocation bufDrawArgs;
+    std::unique_ptr<InstanceCuller> culler;
+    std::unique_ptr<DepthPyramid> depthPyramid; // 每帧从深度缓冲生成，下一帧的剔除做遮挡测试
+    // meshletCulling 时：meshlet 数据（只读）、剔除后的 Uint32 索引、间接绘制参数（后两者从 outputPool 分配）
+    std::vector<uint32_t> meshletLevelFirst;    // 第 l 级 LOD 的 meshlet 为 [meshletLevelFirst[l], meshletLevelFirst[l + 1])
+    BufferAllocation bufMeshlets;
+    BufferAllocation bufMeshletVertices;
+    BufferAllocation bufMeshletTriangles;
+    BufferAllocation bufMeshletIndices;
+    BufferAllocation bufMeshletState;
+    std::unique_ptr<MeshletCuller> meshletCuller;
+
+    wgpu::BindGroup bindGroup;
+    BufferAllocation bufUniform;    // framesInFlight 份 uniform，每份相隔 uniformStride
+    BufferAllocation bufMeshUniform;    // 网格的还原参数（MeshUniforms）
+    uint32_t uniformStride = 0;
+    std::vector<FrameSlot> frameSlots;
+    wgpu::BindGroupLayout layoutBindGroup;  // 同上，由 pipelineCache 持有
+    std::vector<wgpu::BindGroupLayoutEntry> bindGroupEntries;   // layoutBindGroup 的内容，热重载时核对
+    wgpu::PipelineLayout layoutPipeline;
+
+    std::unique_ptr<RenderBundleCache> staticBundles;  // 每个 frame slot 一份（动态偏移不同）
+    std::unique_ptr<DrawQueue> drawQueue;   // 静态绘制经它排序、去掉重复的状态设置后编码
+};
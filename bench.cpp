@@ -0,0 +1,291 @@
+#include "application.h"
+#include "webgpu-utils.h"
+#include "readback-service.h"
+#include "upload-belt.h"
+#include "pipeline-cache.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <atomic>
+
+
+// 性能基准：复用 Application 的 headless 初始化，测量
+//  - frame      : MainLoop() 画索引四边形（--instances 个实例，一次 drawIndexed）的帧耗时 / 帧率
+//  - submit     : 空命令缓冲 submit 到 onSubmittedWorkDone 的往返延迟
+//  - write      : queue.writeBuffer 上传带宽，4 B ~ 64 MB
+//  - belt       : 同样的数据经 UploadBelt 上传（写进映射内存 + copyBufferToBuffer），与 write 对比
+//  - copy       : copyBufferToBuffer 带宽（同 PlayingWithBuffers 的写入->复制）
+//  - map_read   : 复制到 MapRead buffer + mapAsync + 读取 + unmap 的往返延迟
+//  - readback   : ReadbackService 同时在途 8 个回读，全部交付的耗时（bytes 为 8 次的总量）
+// 结果以 JSON 输出（min/median/p99，单位毫秒），默认使用软件/回退适配器，方便在没有 GPU 的机器上追踪回归。
+//
+// 用法: Bench [--hardware] [--frames N] [--instances N] [--gpu-culling] [--output file.json]
+
+namespace {
+
+struct Sample {
+    std::string name;
+    uint64_t bytes = 0;             // 每次迭代处理的字节数，0 表示不计算带宽
+    std::vector<double> millis;
+};
+
+double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    // nearest-rank
+    size_t rank = static_cast<size_t>(p * static_cast<double>(sorted.size()) + 0.5);
+    rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 大块数据迭代次数少一些，小块数据多跑几次让统计更稳
+uint32_t IterationsFor(uint64_t bytes) {
+    uint64_t budget = 256ull << 20; // 每个场景大约搬 256 MB
+    uint64_t n = budget / std::max<uint64_t>(bytes, 1);
+    return static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(n, 5), 200));
+}
+
+Sample Measure(const std::string& name, uint64_t bytes, uint32_t warmup, uint32_t iterations, const std::function<void()>& body) {
+    for (uint32_t i = 0; i < warmup; ++i) {
+        body();
+    }
+    Sample sample;
+    sample.name = name;
+    sample.bytes = bytes;
+    sample.millis.reserve(iterations);
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        sample.millis.push_back(ElapsedMs(start));
+    }
+    return sample;
+}
+
+wgpu::Buffer CreateBuffer(wgpu::Device device, uint64_t size, WGPUBufferUsageFlags usage, const char* label) {
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = label;
+    bufferDesc.size = size;
+    bufferDesc.usage = usage;
+    bufferDesc.mappedAtCreation = false;
+    return device.createBuffer(bufferDesc);
+}
+
+void Submit(wgpu::Device device, wgpu::Queue queue, const std::function<void(wgpu::CommandEncoder)>& record) {
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+    record(encoder);
+    wgpu::CommandBuffer command = encoder.finish(wgpu::Default);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+}
+
+std::string ToJson(const std::vector<Sample>& samples, const ApplicationOptions& options, const PipelineCache::Stats& pipelineStats) {
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"fallbackAdapter\": " << (options.forceFallbackAdapter ? "true" : "false") << ",\n";
+    out << "  \"width\": " << options.width << ",\n";
+    out << "  \"height\": " << options.height << ",\n";
+    out << "  \"instances\": " << options.instanceCount << ",\n";
+    out << "  \"gpuCulling\": " << (options.gpuCulling ? "true" : "false") << ",\n";
+    out << "  \"pipelineCache\": {\"hits\": " << pipelineStats.pipelineHits << ", \"misses\": " << pipelineStats.pipelineMisses
+        << ", \"create_ms\": " << pipelineStats.createMillis << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        std::vector<double> sorted = samples[i].millis;
+        std::sort(sorted.begin(), sorted.end());
+        double median = Percentile(sorted, 0.5);
+        out << "    {\"name\": \"" << samples[i].name << "\""
+            << ", \"bytes\": " << samples[i].bytes
+            << ", \"iterations\": " << sorted.size()
+            << ", \"min_ms\": " << (sorted.empty() ? 0.0 : sorted.front())
+            << ", \"median_ms\": " << median
+            << ", \"p99_ms\": " << Percentile(sorted, 0.99);
+        if (samples[i].bytes > 0 && median > 0.0) {
+            out << ", \"median_mb_per_s\": " << (static_cast<double>(samples[i].bytes) / (1024.0 * 1024.0)) / (median / 1000.0);
+        }
+        if (samples[i].name == "frame" && median > 0.0) {
+            out << ", \"median_fps\": " << 1000.0 / median;
+        }
+        out << "}" << (i + 1 < samples.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return out.str();
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    ApplicationOptions options;
+    options.headless = true;
+    options.forceFallbackAdapter = true;
+    options.maxBufferSize = 64ull << 20;
+    options.asyncPipelineCompile = false;   // 帧耗时要测正式 pipeline，不要混进占位 pipeline 的帧
+    uint32_t frameCount = 500;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hardware") {
+            options.forceFallbackAdapter = false;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--instances" && i + 1 < argc) {
+            options.instanceCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--gpu-culling") {
+            options.gpuCulling = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Application 初始化时会往 stdout 打印适配器信息，先改到 stderr，保证 stdout 只有 JSON
+    std::streambuf* coutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    Application app(options);
+    if (!app.Initialize()) {
+        std::cout.rdbuf(coutBuffer);
+        std::cerr << "Failed to initialize application." << std::endl;
+        return 1;
+    }
+    wgpu::Device device = app.GetDevice();
+    wgpu::Queue queue = app.GetQueue();
+
+    std::vector<Sample> samples;
+
+    // 1. 帧吞吐：headless 的 MainLoop 不受 vsync 限制，CPU 最多领先 GPU framesInFlight 帧
+    samples.push_back(Measure("frame", 0, 20, frameCount, [&app]() { app.MainLoop(); }));
+
+    // 2. submit 往返延迟
+    samples.push_back(Measure("submit", 0, 10, 200, [&]() {
+        Submit(device, queue, [](wgpu::CommandEncoder) {});
+        waitForQueueIdle(device, queue);
+    }));
+
+    const std::vector<uint64_t> sizes = { 4, 64, 1ull << 10, 16ull << 10, 256ull << 10, 4ull << 20, 64ull << 20 };
+    const uint64_t maxSize = sizes.back();
+    std::vector<uint8_t> cpuData(maxSize);
+    for (size_t i = 0; i < cpuData.size(); ++i) {
+        cpuData[i] = static_cast<uint8_t>(i);
+    }
+
+    wgpu::Buffer src = CreateBuffer(device, maxSize, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc, "Bench source buffer");
+    wgpu::Buffer dst = CreateBuffer(device, maxSize, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc, "Bench destination buffer");
+    wgpu::Buffer readback = CreateBuffer(device, maxSize, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead, "Bench readback buffer");
+
+    // 3. writeBuffer 上传带宽（包含等待 GPU 真正拿到数据的时间）
+    for (uint64_t size : sizes) {
+        samples.push_back(Measure("write_" + std::to_string(size), size, 2, IterationsFor(size), [&]() {
+            queue.writeBuffer(src, 0, cpuData.data(), size);
+            waitForQueueIdle(device, queue);
+        }));
+    }
+    {
+        UploadBelt belt(device, 4ull << 20);
+        for (uint64_t size : sizes) {
+            samples.push_back(Measure("belt_" + std::to_string(size), size, 2, IterationsFor(size), [&]() {
+                Submit(device, queue, [&](wgpu::CommandEncoder encoder) {
+                    belt.Write(encoder, src, 0, cpuData.data(), size);
+                    belt.Finish();
+                });
+                belt.Recall();
+                waitForQueueIdle(device, queue);
+            }));
+        }
+        waitForQueueIdle(device, queue); // 让 chunk 的重新映射完成后再销毁
+    }
+
+    // 4. buffer -> buffer 复制带宽
+    queue.writeBuffer(src, 0, cpuData.data(), maxSize);
+    waitForQueueIdle(device, queue);
+    for (uint64_t size : sizes) {
+        samples.push_back(Measure("copy_" + std::to_string(size), size, 2, IterationsFor(size), [&]() {
+            Submit(device, queue, [&](wgpu::CommandEncoder encoder) {
+                encoder.copyBufferToBuffer(src, 0, dst, 0, size);
+            });
+            waitForQueueIdle(device, queue);
+        }));
+    }
+
+    // 5. map-read 往返：复制 -> mapAsync -> 读取 -> unmap
+    for (uint64_t size : sizes) {
+        samples.push_back(Measure("map_read_" + std::to_string(size), size, 2, IterationsFor(size), [&]() {
+            Submit(device, queue, [&](wgpu::CommandEncoder encoder) {
+                encoder.copyBufferToBuffer(src, 0, readback, 0, size);
+            });
+            std::atomic<bool> ready{ false }; // app 的 ReadbackService 也在 poll，回调可能在它的线程上执行
+            auto handle = readback.mapAsync(wgpu::MapMode::Read, 0, size, [&ready](wgpu::BufferMapAsyncStatus status) {
+                if (status != wgpu::BufferMapAsyncStatus::Success) {
+                    std::cerr << "readback map failed, status=" << (int)status << std::endl;
+                }
+                ready = true;
+            });
+            while (!ready) {
+#if defined(WEBGPU_BACKEND_DAWN)
+                device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+                device.poll(true);
+#endif
+            }
+            volatile uint8_t sink = static_cast<const uint8_t*>(readback.getConstMappedRange(0, size))[size - 1];
+            (void)sink;
+            readback.unmap();
+        }));
+    }
+
+    // 6. ReadbackService：多个回读同时在途，由 poll 线程交付
+    const uint32_t kConcurrentReads = 8;
+    ReadbackService& service = app.GetReadbackService();
+    for (uint64_t size : sizes) {
+        if (size * kConcurrentReads > maxSize) {
+            break;
+        }
+        samples.push_back(Measure("readback_" + std::to_string(size), size * kConcurrentReads, 2, IterationsFor(size * kConcurrentReads), [&]() {
+            std::vector<std::future<ReadbackService::Result>> futures;
+            for (uint32_t i = 0; i < kConcurrentReads; ++i) {
+                futures.push_back(service.ReadBuffer(src, i * size, size));
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+        }));
+    }
+
+    src.destroy();
+    src.release();
+    dst.destroy();
+    dst.release();
+    readback.destroy();
+    readback.release();
+    PipelineCache::Stats pipelineStats = app.GetPipelineCache().GetStats();
+    app.Terminate();
+
+    std::cout.rdbuf(coutBuffer);
+    std::string json = ToJson(samples, options, pipelineStats);
+    if (outputPath.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(outputPath);
+        if (!file) {
+            std::cerr << "Could not write " << outputPath << std::endl;
+            return 1;
+        }
+        file << json;
+    }
+    return 0;
+}
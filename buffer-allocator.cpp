@@ -0,0 +1,193 @@
+#include "buffer-allocator.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+
+RangeAllocator::RangeAllocator(uint64_t capacity)
+    : capacity(capacity) {
+    if (capacity > 0) {
+        InsertFree(0, capacity);
+    }
+}
+
+void RangeAllocator::InsertFree(uint64_t offset, uint64_t size) {
+    freeByOffset.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+    freeBytes += size;
+}
+
+void RangeAllocator::EraseFree(std::map<uint64_t, uint64_t>::iterator it) {
+    auto range = freeBySize.equal_range(it->second);
+    for (auto s = range.first; s != range.second; ++s) {
+        if (s->second == it->first) {
+            freeBySize.erase(s);
+            break;
+        }
+    }
+    freeBytes -= it->second;
+    freeByOffset.erase(it);
+}
+
+bool RangeAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    if (size == 0) {
+        return false;
+    }
+    // 从刚好够大的块开始往上找，第一个能放下（算上对齐填充）的就是 best-fit
+    for (auto s = freeBySize.lower_bound(size); s != freeBySize.end(); ++s) {
+        uint64_t blockOffset = s->second;
+        uint64_t blockSize = s->first;
+        uint64_t aligned = AlignUp(blockOffset, alignment);
+        if (aligned + size > blockOffset + blockSize) {
+            continue;
+        }
+        EraseFree(freeByOffset.find(blockOffset));
+        // 对齐产生的前部空隙、用剩的尾部都还给空闲表
+        if (aligned > blockOffset) {
+            InsertFree(blockOffset, aligned - blockOffset);
+        }
+        uint64_t end = aligned + size;
+        if (end < blockOffset + blockSize) {
+            InsertFree(end, blockOffset + blockSize - end);
+        }
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::Free(uint64_t offset, uint64_t size) {
+    uint64_t begin = offset;
+    uint64_t end = offset + size;
+    // 与后面紧挨着的空闲块合并
+    auto next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.end() && next->first == end) {
+        end += next->second;
+        EraseFree(next);
+    }
+    // 与前面紧挨着的空闲块合并
+    auto prev = freeByOffset.lower_bound(offset);
+    if (prev != freeByOffset.begin()) {
+        --prev;
+        if (prev->first + prev->second == begin) {
+            begin = prev->first;
+            EraseFree(prev);
+        }
+    }
+    InsertFree(begin, end - begin);
+}
+
+
+BufferSubAllocator::BufferSubAllocator(wgpu::Device device, WGPUBufferUsageFlags usage, uint64_t pageSize, const char* label)
+    : device(device), usage(usage), pageSize(AlignUp(pageSize, 4)), label(label) {
+}
+
+BufferSubAllocator::~BufferSubAllocator() {
+    if (allocationCount > 0) {
+        std::cout << "BufferSubAllocator '" << (label ? label : "") << "' destroyed with "
+                  << allocationCount << " live allocations" << std::endl;
+    }
+    for (auto& page : pages) {
+        if (page) {
+            page->buffer.destroy();
+            page->buffer.release();
+        }
+    }
+}
+
+BufferSubAllocator::Page* BufferSubAllocator::CreatePage(uint64_t size) {
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = label;
+    bufferDesc.size = size;
+    bufferDesc.usage = usage;
+    bufferDesc.mappedAtCreation = false;
+
+    auto page = std::make_unique<Page>(size);
+    page->buffer = device.createBuffer(bufferDesc);
+    if (page->buffer == nullptr) {
+        return nullptr;
+    }
+    for (auto& slot : pages) {
+        if (!slot) {
+            slot = std::move(page);
+            return slot.get();
+        }
+    }
+    pages.push_back(std::move(page));
+    return pages.back().get();
+}
+
+BufferAllocation BufferSubAllocator::Allocate(uint64_t size, uint64_t alignment) {
+    BufferAllocation allocation;
+    size = AlignUp(size, 4);
+    alignment = std::max<uint64_t>(alignment, 4);
+
+    uint64_t offset = 0;
+    Page* target = nullptr;
+    for (auto& page : pages) {
+        if (page && page->ranges.Allocate(size, alignment, offset)) {
+            target = page.get();
+            break;
+        }
+    }
+    if (target == nullptr) {
+        // 普通请求开一个新页；比页还大的请求单独占一页
+        target = CreatePage(std::max(pageSize, size));
+        if (target == nullptr || !target->ranges.Allocate(size, alignment, offset)) {
+            std::cout << "BufferSubAllocator: failed to allocate " << size << " bytes" << std::endl;
+            return allocation;
+        }
+    }
+
+    for (uint32_t i = 0; i < pages.size(); ++i) {
+        if (pages[i].get() == target) {
+            allocation.page = i;
+            break;
+        }
+    }
+    allocation.buffer = target->buffer;
+    allocation.offset = offset;
+    allocation.size = size;
+    ++allocationCount;
+    allocatedBytes += size;
+    return allocation;
+}
+
+void BufferSubAllocator::Free(BufferAllocation& allocation) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+    assert(allocation.page < pages.size() && pages[allocation.page]);
+    Page& page = *pages[allocation.page];
+    page.ranges.Free(allocation.offset, allocation.size);
+    --allocationCount;
+    allocatedBytes -= allocation.size;
+
+    // 单独的大页空了就直接还给驱动，普通页留着复用
+    if (page.ranges.IsEmpty() && page.ranges.GetCapacity() > pageSize) {
+        page.buffer.destroy();
+        page.buffer.release();
+        pages[allocation.page].reset();
+    }
+    allocation = BufferAllocation();
+}
+
+uint32_t BufferSubAllocator::GetPageCount() const {
+    uint32_t count = 0;
+    for (const auto& page : pages) {
+        if (page) {
+            ++count;
+        }
+    }
+    return count;
+}
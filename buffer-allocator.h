@@ -0,0 +1,81 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <map>
+#include <vector>
+#include <memory>
+
+// 在一段 [0, capacity) 的区间里分配子区间，只管理数字，不碰 GPU。
+// 空闲块按 offset 和按 size 各索引一次：分配取能放下（含对齐填充）的最小块（best-fit），释放时与左右相邻空闲块合并。
+class RangeAllocator {
+public:
+    explicit RangeAllocator(uint64_t capacity);
+
+    // alignment 必须是 2 的幂；放不下返回 false
+    bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+    // offset/size 必须与 Allocate 得到的一致
+    void Free(uint64_t offset, uint64_t size);
+
+    uint64_t GetCapacity() const { return capacity; }
+    uint64_t GetFreeBytes() const { return freeBytes; }
+    bool IsEmpty() const { return freeBytes == capacity; }
+
+private:
+    void InsertFree(uint64_t offset, uint64_t size);
+    void EraseFree(std::map<uint64_t, uint64_t>::iterator it);
+
+private:
+    uint64_t capacity = 0;
+    uint64_t freeBytes = 0;
+    std::map<uint64_t, uint64_t> freeByOffset;      // offset -> size
+    std::multimap<uint64_t, uint64_t> freeBySize;   // size -> offset
+};
+
+// 子分配得到的一段 GPU 内存：(buffer, offset, size)
+struct BufferAllocation {
+    wgpu::Buffer buffer = nullptr;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t page = 0;      // 内部使用：来自哪一页
+
+    bool IsValid() const { return buffer != nullptr; }
+};
+
+// 从少数几个大 wgpu::Buffer（页）里切出顶点/索引/uniform 等小块，代替每个网格各建一个 buffer，
+// 减少 buffer 数量、校验开销和绑定切换。超过页大小的请求单独占一页。
+class BufferSubAllocator {
+public:
+    // usage 决定池子里的数据能怎么用，如 Vertex | Index | Uniform | CopyDst
+    BufferSubAllocator(wgpu::Device device, WGPUBufferUsageFlags usage, uint64_t pageSize, const char* label);
+    ~BufferSubAllocator();
+
+    BufferSubAllocator(const BufferSubAllocator&) = delete;
+    BufferSubAllocator& operator=(const BufferSubAllocator&) = delete;
+
+    // size 会向上取整到 4 的倍数（writeBuffer/copy 的要求）；alignment 取所需用途里最严格的那个：
+    // 顶点/索引为 4，uniform 为 minUniformBufferOffsetAlignment，storage 为 minStorageBufferOffsetAlignment
+    BufferAllocation Allocate(uint64_t size, uint64_t alignment = 4);
+    // 释放后 allocation 被清空；调用方需保证 GPU 已不再使用这段内存
+    void Free(BufferAllocation& allocation);
+
+    uint32_t GetPageCount() const;
+    uint32_t GetAllocationCount() const { return allocationCount; }
+    uint64_t GetAllocatedBytes() const { return allocatedBytes; }
+
+private:
+    struct Page {
+        wgpu::Buffer buffer = nullptr;
+        RangeAllocator ranges;
+        explicit Page(uint64_t size) : ranges(size) {}
+    };
+    Page* CreatePage(uint64_t size);
+
+private:
+    wgpu::Device device = nullptr;
+    WGPUBufferUsageFlags usage = 0;
+    uint64_t pageSize = 0;
+    const char* label = nullptr;
+    std::vector<std::unique_ptr<Page>> pages; // 释放掉的单独大页留空位，保持 page 下标不变
+    uint32_t allocationCount = 0;
+    uint64_t allocatedBytes = 0;
+};
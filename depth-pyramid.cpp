@@ -0,0 +1,262 @@
+#include "depth-pyramid.h"
+#include "shader-reflection.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const uint32_t kWorkgroupSize = 8;  // 8x8
+
+// 深度缓冲 -> 第 0 级，逐 texel 复制
+const char* copyShaderSource = R"(
+@group(0) @binding(0) var depth : texture_depth_2d;
+@group(0) @binding(1) var target : texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let size = textureDimensions(target);
+    if (id.x >= size.x || id.y >= size.y) {
+        return;
+    }
+    textureStore(target, id.xy, vec4f(textureLoad(depth, id.xy, 0), 0.0, 0.0, 1.0));
+}
+)";
+
+// 第 i - 1 级 -> 第 i 级：2x2 取最大；上一级是奇数边时，最后一行/列的 texel 把多出来的那一行/列也算进去
+const char* reduceShaderSource = R"(
+@group(0) @binding(0) var source : texture_2d<f32>;
+@group(0) @binding(1) var target : texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let size = textureDimensions(target);
+    if (id.x >= size.x || id.y >= size.y) {
+        return;
+    }
+    let sourceSize = textureDimensions(source);
+    let begin = id.xy * 2u;
+    var end = min(begin + vec2u(2u), sourceSize);
+    if (id.x + 1u == size.x) {
+        end.x = sourceSize.x;
+    }
+    if (id.y + 1u == size.y) {
+        end.y = sourceSize.y;
+    }
+    var farthest = 0.0;
+    for (var y = begin.y; y < end.y; y++) {
+        for (var x = begin.x; x < end.x; x++) {
+            farthest = max(farthest, textureLoad(source, vec2u(x, y), 0).r);
+        }
+    }
+    textureStore(target, id.xy, vec4f(farthest, 0.0, 0.0, 1.0));
+}
+)";
+
+// 布局从反射得到；R32Float 不可过滤，反射给的 Float 要改成 UnfilterableFloat
+bool createPipeline(wgpu::Device device, const char* source, const char* label, wgpu::BindGroupLayout& layout,
+                    wgpu::PipelineLayout& pipelineLayout, wgpu::ComputePipeline& pipeline) {
+    ShaderReflection reflection;
+    if (!reflection.Parse(source)) {
+        return false;
+    }
+    std::vector<wgpu::BindGroupLayoutEntry> layoutEntries = reflection.GetBindGroupLayoutEntries(0);
+    if (layoutEntries.size() != 2) {
+        std::cout << "DepthPyramid: unexpected bindings in " << label << std::endl;
+        return false;
+    }
+    if (layoutEntries[0].texture.sampleType == wgpu::TextureSampleType::Float) {
+        layoutEntries[0].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+    }
+
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = source;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+#ifdef WEBGPU_BACKEND_WGPU
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+#endif
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    wgpu::ShaderModule shaderModule = device.createShaderModule(shaderDesc);
+
+    wgpu::BindGroupLayoutDescriptor descGroupLayout{};
+    descGroupLayout.entryCount = layoutEntries.size();
+    descGroupLayout.entries = layoutEntries.data();
+    layout = device.createBindGroupLayout(descGroupLayout);
+
+    wgpu::PipelineLayoutDescriptor descPipelineLayout{};
+    descPipelineLayout.bindGroupLayoutCount = 1;
+    descPipelineLayout.bindGroupLayouts = (WGPUBindGroupLayout*)&layout;
+    pipelineLayout = device.createPipelineLayout(descPipelineLayout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = label;
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = shaderModule;
+    pipelineDesc.compute.entryPoint = "cs_main";
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+    pipeline = device.createComputePipeline(pipelineDesc);
+    shaderModule.release();
+    return pipeline != nullptr;
+}
+
+wgpu::BindGroup createBindGroup(wgpu::Device device, wgpu::BindGroupLayout layout, wgpu::TextureView source, wgpu::TextureView target) {
+    std::vector<wgpu::BindGroupEntry> entries(2, wgpu::Default);
+    entries[0].binding = 0;
+    entries[0].textureView = source;
+    entries[1].binding = 1;
+    entries[1].textureView = target;
+    wgpu::BindGroupDescriptor descBindGroup{};
+    descBindGroup.layout = layout;
+    descBindGroup.entryCount = entries.size();
+    descBindGroup.entries = entries.data();
+    return device.createBindGroup(descBindGroup);
+}
+
+} // namespace
+
+
+DepthPyramid::DepthPyramid(wgpu::Device device)
+    : device(device) {
+}
+
+DepthPyramid::~DepthPyramid() {
+    ReleaseTexture();
+    for (wgpu::ComputePipeline* pipeline : { &copyPipeline, &reducePipeline }) {
+        if (*pipeline != nullptr) {
+            pipeline->release();
+        }
+    }
+    for (wgpu::PipelineLayout* layout : { &copyPipelineLayout, &reducePipelineLayout }) {
+        if (*layout != nullptr) {
+            layout->release();
+        }
+    }
+    for (wgpu::BindGroupLayout* layout : { &copyLayout, &reduceLayout }) {
+        if (*layout != nullptr) {
+            layout->release();
+        }
+    }
+}
+
+bool DepthPyramid::Initialize() {
+    return createPipeline(device, copyShaderSource, "Depth pyramid copy", copyLayout, copyPipelineLayout, copyPipeline)
+        && createPipeline(device, reduceShaderSource, "Depth pyramid reduce", reduceLayout, reducePipelineLayout, reducePipeline);
+}
+
+void DepthPyramid::ReleaseTexture() {
+    for (wgpu::BindGroup& bindGroup : bindGroups) {
+        bindGroup.release();
+    }
+    for (wgpu::TextureView& levelView : levelViews) {
+        levelView.release();
+    }
+    bindGroups.clear();
+    levelViews.clear();
+    levelWidths.clear();
+    levelHeights.clear();
+    if (view != nullptr) {
+        view.release();
+        view = nullptr;
+    }
+    if (texture != nullptr) {
+        texture.destroy();
+        texture.release();
+        texture = nullptr;
+    }
+}
+
+void DepthPyramid::Resize(wgpu::TextureView depthView, uint32_t width, uint32_t height) {
+    ReleaseTexture();
+    width = std::max(width, 1u);
+    height = std::max(height, 1u);
+    for (uint32_t w = width, h = height;; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+        levelWidths.push_back(w);
+        levelHeights.push_back(h);
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+    uint32_t levelCount = static_cast<uint32_t>(levelWidths.size());
+
+    wgpu::TextureDescriptor textureDesc;
+    textureDesc.label = "Depth pyramid";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.format = wgpu::TextureFormat::R32Float;
+    textureDesc.size = { width, height, 1 };
+    textureDesc.mipLevelCount = levelCount;
+    textureDesc.sampleCount = 1;
+    // RenderAttachment：只为了建好后用 clear 把各级填成 1.0
+    textureDesc.usage = wgpu::TextureUsage::StorageBinding | wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::RenderAttachment;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    texture = device.createTexture(textureDesc);
+
+    wgpu::TextureViewDescriptor viewDesc;
+    viewDesc.format = wgpu::TextureFormat::R32Float;
+    viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = levelCount;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = wgpu::TextureAspect::All;
+    view = texture.createView(viewDesc);
+
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        viewDesc.baseMipLevel = level;
+        viewDesc.mipLevelCount = 1;
+        levelViews.push_back(texture.createView(viewDesc));
+
+        wgpu::RenderPassColorAttachment clearAttachment = {};
+        clearAttachment.view = levelViews.back();
+        clearAttachment.resolveTarget = nullptr;
+        clearAttachment.loadOp = wgpu::LoadOp::Clear;
+        clearAttachment.storeOp = wgpu::StoreOp::Store;
+        clearAttachment.clearValue = wgpu::Color{ 1.0, 0.0, 0.0, 1.0 };
+#ifndef WEBGPU_BACKEND_WGPU
+        clearAttachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
+#endif // NOT WEBGPU_BACKEND_WGPU
+        wgpu::RenderPassDescriptor clearDesc = {};
+        clearDesc.colorAttachmentCount = 1;
+        clearDesc.colorAttachments = &clearAttachment;
+        clearDesc.depthStencilAttachment = nullptr;
+        clearDesc.timestampWrites = nullptr;
+        wgpu::RenderPassEncoder clearPass = encoder.beginRenderPass(clearDesc);
+        clearPass.end();
+        clearPass.release();
+
+        if (depthView != nullptr) {
+            wgpu::TextureView source = level == 0 ? depthView : levelViews[level - 1];
+            bindGroups.push_back(createBindGroup(device, level == 0 ? copyLayout : reduceLayout, source, levelViews[level]));
+        }
+    }
+    wgpu::CommandBuffer command = encoder.finish(wgpu::Default);
+    encoder.release();
+    wgpu::Queue queue = device.getQueue();
+    queue.submit(1, &command);
+    command.release();
+    queue.release();
+}
+
+void DepthPyramid::Record(wgpu::CommandEncoder encoder) {
+    if (bindGroups.empty()) {
+        return;
+    }
+    wgpu::ComputePassDescriptor passDesc;
+    passDesc.label = "Depth pyramid pass";
+    passDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass(passDesc);
+    // 同一个 pass 里逐级 dispatch：后一级读的是前一级的 storage 写入，dispatch 之间有隐式的同步
+    for (uint32_t level = 0; level < bindGroups.size(); ++level) {
+        computePass.setPipeline(level == 0 ? copyPipeline : reducePipeline);
+        computePass.setBindGroup(0, bindGroups[level], 0, nullptr);
+        computePass.dispatchWorkgroups((levelWidths[level] + kWorkgroupSize - 1) / kWorkgroupSize,
+                                       (levelHeights[level] + kWorkgroupSize - 1) / kWorkgroupSize, 1);
+    }
+    computePass.end();
+    computePass.release();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// 深度金字塔（Hi-Z）：R32Float 纹理，第 0 级与深度缓冲一样大，之后每级的一个 texel 存上一级 2x2 范围
+// （奇数边的最后一个 texel 多带一行/列）里的最大深度，也就是最远的深度。
+// 每帧 render pass 结束后用 compute pass 从深度缓冲逐级生成，下一帧的剔除拿它做遮挡测试：
+// 物体最近处的深度比它覆盖区域里最远的深度还远，就一定被挡住了。
+class DepthPyramid {
+public:
+    explicit DepthPyramid(wgpu::Device device);
+    ~DepthPyramid();
+
+    DepthPyramid(const DepthPyramid&) = delete;
+    DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+    // 创建两个 compute pipeline（深度 -> 第 0 级，逐级取最大）；失败时打印原因并返回 false
+    bool Initialize();
+    // 按深度缓冲（重新）创建纹理与各级的 bind group。depthView 须带 TextureBinding 用途。
+    // 所有级先清成 1.0（最远），重建之后的第一帧不会剔除任何东西；
+    // depthView 为空时只建纹理，一直保持 1.0，Record 什么也不做
+    void Resize(wgpu::TextureView depthView, uint32_t width, uint32_t height);
+
+    // 录制到 encoder，须在写深度的 render pass 结束之后
+    void Record(wgpu::CommandEncoder encoder);
+
+    // 包含所有级的视图，剔除 shader 里按 texture_2d<f32> + textureLoad 读
+    wgpu::TextureView GetView() const { return view; }
+
+private:
+    void ReleaseTexture();
+
+private:
+    wgpu::Device device = nullptr;
+    wgpu::ComputePipeline copyPipeline = nullptr;
+    wgpu::ComputePipeline reducePipeline = nullptr;
+    wgpu::BindGroupLayout copyLayout = nullptr;
+    wgpu::BindGroupLayout reduceLayout = nullptr;
+    wgpu::PipelineLayout copyPipelineLayout = nullptr;
+    wgpu::PipelineLayout reducePipelineLayout = nullptr;
+
+    wgpu::Texture texture = nullptr;
+    wgpu::TextureView view = nullptr;
+    std::vector<wgpu::TextureView> levelViews;  // 每级一个单独的视图，作 storage 写 / 下一级的输入
+    std::vector<wgpu::BindGroup> bindGroups;    // [0]：深度 -> 第 0 级，[i]：第 i - 1 级 -> 第 i 级
+    std::vector<uint32_t> levelWidths;
+    std::vector<uint32_t> levelHeights;
+};
@@ -0,0 +1,160 @@
+#include "draw-queue.h"
+#include "webgpu-utils.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+bool sameBuffer(const DrawQueue::BufferBinding& a, const DrawQueue::BufferBinding& b) {
+    return a.buffer == b.buffer && a.offset == b.offset && a.size == b.size;
+}
+
+bool sameBindGroup(const DrawQueue::BindGroupBinding& a, const DrawQueue::BindGroupBinding& b) {
+    return a.group == b.group && a.dynamicOffsetCount == b.dynamicOffsetCount
+        && std::equal(a.dynamicOffsets, a.dynamicOffsets + a.dynamicOffsetCount, b.dynamicOffsets);
+}
+
+uint64_t handleBits(const void* handle) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+}
+
+} // namespace
+
+
+void DrawQueue::Enqueue(const Draw& draw) {
+    draws.push_back(draw);
+}
+
+void DrawQueue::ResetIds() {
+    pipelineIds.clear();
+    materialIds.clear();
+}
+
+uint32_t DrawQueue::GetPipelineId(const Draw& draw) {
+    auto it = pipelineIds.find(draw.pipeline);
+    if (it != pipelineIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(pipelineIds.size());
+    pipelineIds.emplace(draw.pipeline, id);
+    return id;
+}
+
+uint32_t DrawQueue::GetMaterialId(const Draw& draw) {
+    // bind group（含动态偏移）与顶点 / 索引 buffer 的绑定逐个并进 FNV 状态；深度与绘制参数不算在内
+    uint64_t hash = hashFnv1a(nullptr, 0);
+    auto mix = [&hash](uint64_t value) { hash = hashFnv1a(&value, sizeof(value), hash); };
+    for (uint32_t g = 0; g < draw.bindGroupCount; ++g) {
+        const BindGroupBinding& binding = draw.bindGroups[g];
+        mix(handleBits(static_cast<WGPUBindGroup>(binding.group)));
+        mix(binding.dynamicOffsetCount);
+        for (uint32_t i = 0; i < binding.dynamicOffsetCount; ++i) {
+            mix(binding.dynamicOffsets[i]);
+        }
+    }
+    for (uint32_t slot = 0; slot < draw.vertexBufferCount; ++slot) {
+        const BufferBinding& binding = draw.vertexBuffers[slot];
+        mix(handleBits(static_cast<WGPUBuffer>(binding.buffer)));
+        mix(binding.offset);
+        mix(binding.size);
+    }
+    mix(handleBits(static_cast<WGPUBuffer>(draw.indexBuffer.buffer)));
+    mix(draw.indexBuffer.offset);
+    mix(draw.indexBuffer.size);
+    mix(static_cast<uint64_t>(draw.indexFormat));
+
+    auto it = materialIds.find(hash);
+    if (it != materialIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(materialIds.size());
+    materialIds.emplace(hash, id);
+    return id;
+}
+
+template <typename Encoder>
+void DrawQueue::Submit(Encoder encoder) {
+    items.resize(draws.size());
+    for (uint32_t i = 0; i < draws.size(); ++i) {
+        items[i].key = packDrawSortKey(GetPipelineId(draws[i]), GetMaterialId(draws[i]), draws[i].depth);
+        items[i].index = i;
+    }
+    radixSortDrawItems(items);
+
+    // encoder 上当前的状态；bundle / pass 开始时什么都没有设置
+    wgpu::RenderPipeline boundPipeline = nullptr;
+    BindGroupBinding boundGroups[kMaxBindGroups];
+    BufferBinding boundVertexBuffers[kMaxVertexBuffers];
+    BufferBinding boundIndexBuffer;
+    wgpu::IndexFormat boundIndexFormat = wgpu::IndexFormat::Undefined;
+
+    for (const DrawSortItem& item : items) {
+        const Draw& draw = draws[item.index];
+        if (boundPipeline != draw.pipeline) {
+            encoder.setPipeline(draw.pipeline);
+            boundPipeline = draw.pipeline;
+            ++stats.pipelineEmitted;
+        } else {
+            ++stats.pipelineSkipped;
+        }
+        for (uint32_t g = 0; g < std::min(draw.bindGroupCount, kMaxBindGroups); ++g) {
+            const BindGroupBinding& binding = draw.bindGroups[g];
+            if (!sameBindGroup(boundGroups[g], binding)) {
+                encoder.setBindGroup(g, binding.group, binding.dynamicOffsetCount, binding.dynamicOffsets);
+                boundGroups[g] = binding;
+                ++stats.bindGroupEmitted;
+            } else {
+                ++stats.bindGroupSkipped;
+            }
+        }
+        for (uint32_t slot = 0; slot < std::min(draw.vertexBufferCount, kMaxVertexBuffers); ++slot) {
+            const BufferBinding& binding = draw.vertexBuffers[slot];
+            if (!sameBuffer(boundVertexBuffers[slot], binding)) {
+                encoder.setVertexBuffer(slot, binding.buffer, binding.offset, binding.size);
+                boundVertexBuffers[slot] = binding;
+                ++stats.vertexBufferEmitted;
+            } else {
+                ++stats.vertexBufferSkipped;
+            }
+        }
+
+        bool indexed = draw.indexBuffer.buffer != nullptr;
+        if (indexed) {
+            if (!sameBuffer(boundIndexBuffer, draw.indexBuffer) || boundIndexFormat != draw.indexFormat) {
+                encoder.setIndexBuffer(draw.indexBuffer.buffer, draw.indexFormat, draw.indexBuffer.offset, draw.indexBuffer.size);
+                boundIndexBuffer = draw.indexBuffer;
+                boundIndexFormat = draw.indexFormat;
+                ++stats.indexBufferEmitted;
+            } else {
+                ++stats.indexBufferSkipped;
+            }
+        }
+
+        if (draw.indirectBuffer != nullptr) {
+            if (indexed) {
+                encoder.drawIndexedIndirect(draw.indirectBuffer, draw.indirectOffset);
+            } else {
+                encoder.drawIndirect(draw.indirectBuffer, draw.indirectOffset);
+            }
+        } else if (indexed) {
+            encoder.drawIndexed(draw.count, draw.instanceCount, draw.first, draw.baseVertex, draw.firstInstance);
+        } else {
+            encoder.draw(draw.count, draw.instanceCount, draw.first, draw.firstInstance);
+        }
+        ++stats.draws;
+    }
+    draws.clear();
+    items.clear();
+}
+
+template void DrawQueue::Submit<wgpu::RenderPassEncoder>(wgpu::RenderPassEncoder encoder);
+template void DrawQueue::Submit<wgpu::RenderBundleEncoder>(wgpu::RenderBundleEncoder encoder);
+
+void DrawQueue::PrintStats() const {
+    std::cout << "Draw queue: " << stats.draws << " draws, calls emitted/skipped: pipeline "
+              << stats.pipelineEmitted << "/" << stats.pipelineSkipped << ", bind group "
+              << stats.bindGroupEmitted << "/" << stats.bindGroupSkipped << ", vertex buffer "
+              << stats.vertexBufferEmitted << "/" << stats.vertexBufferSkipped << ", index buffer "
+              << stats.indexBufferEmitted << "/" << stats.indexBufferSkipped << std::endl;
+}
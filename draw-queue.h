@@ -0,0 +1,88 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "draw-sort.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 绘制命令队列：调用方把每次 draw 连同它需要的 pipeline、bind group、顶点/索引 buffer 和深度放进来，
+// Submit 时按 packDrawSortKey(pipeline, material, depth) 基数排序后再编码，
+// 与上一条命令相同的 setPipeline / setBindGroup / setVertexBuffer / setIndexBuffer 不再重复调用。
+// pipeline 与 material（bind group + buffer 的组合）按首次出现的顺序编号，编号跨帧不变（直到 ResetIds），排序结果稳定。
+// 编号只决定分组，状态是否相同在编码时逐项比较，所以编号截断或哈希冲突都不会画错。
+class DrawQueue {
+public:
+    static constexpr uint32_t kMaxBindGroups = 4;
+    static constexpr uint32_t kMaxDynamicOffsets = 4;
+    static constexpr uint32_t kMaxVertexBuffers = 8;
+
+    struct BufferBinding {
+        wgpu::Buffer buffer = nullptr;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    struct BindGroupBinding {
+        wgpu::BindGroup group = nullptr;
+        uint32_t dynamicOffsetCount = 0;
+        uint32_t dynamicOffsets[kMaxDynamicOffsets] = {};
+    };
+
+    struct Draw {
+        wgpu::RenderPipeline pipeline = nullptr;
+        BindGroupBinding bindGroups[kMaxBindGroups];    // 下标即 group
+        uint32_t bindGroupCount = 0;
+        BufferBinding vertexBuffers[kMaxVertexBuffers]; // 下标即 slot
+        uint32_t vertexBufferCount = 0;
+        BufferBinding indexBuffer;                      // buffer 为空时是 draw，否则是 drawIndexed
+        wgpu::IndexFormat indexFormat = wgpu::IndexFormat::Uint16;
+        // indirectBuffer 为空时直接绘制：count 是 indexCount / vertexCount，first 是 firstIndex / firstVertex
+        uint32_t count = 0;
+        uint32_t instanceCount = 1;
+        uint32_t first = 0;
+        int32_t baseVertex = 0;
+        uint32_t firstInstance = 0;
+        wgpu::Buffer indirectBuffer = nullptr;          // 非空时 drawIndirect / drawIndexedIndirect
+        uint64_t indirectOffset = 0;
+        float depth = 0.0f;                             // [0, 1]，同状态内由近到远
+    };
+
+    // 累计值：emitted 是实际编码的调用，skipped 是因为与当前状态相同而省掉的调用
+    struct Stats {
+        uint64_t draws = 0;
+        uint64_t pipelineEmitted = 0;
+        uint64_t pipelineSkipped = 0;
+        uint64_t bindGroupEmitted = 0;
+        uint64_t bindGroupSkipped = 0;
+        uint64_t vertexBufferEmitted = 0;
+        uint64_t vertexBufferSkipped = 0;
+        uint64_t indexBufferEmitted = 0;
+        uint64_t indexBufferSkipped = 0;
+    };
+
+    void Enqueue(const Draw& draw);
+    // 排序后编码到 encoder（RenderPassEncoder 或 RenderBundleEncoder），然后清空队列。
+    // 编码前 encoder 上没有任何状态：第一条命令的状态总是全部设置
+    template <typename Encoder>
+    void Submit(Encoder encoder);
+
+    // 编号以句柄为 key：pipeline / bind group / buffer 重建后旧句柄可能被复用，编号表也随之清空
+    void ResetIds();
+
+    size_t GetSize() const { return draws.size(); }
+    const Stats& GetStats() const { return stats; }
+    void PrintStats() const;
+
+private:
+    uint32_t GetPipelineId(const Draw& draw);
+    uint32_t GetMaterialId(const Draw& draw);
+
+private:
+    std::vector<Draw> draws;
+    std::vector<DrawSortItem> items;
+    std::unordered_map<WGPURenderPipeline, uint32_t> pipelineIds;
+    std::unordered_map<uint64_t, uint32_t> materialIds;    // 状态的哈希 -> 编号
+    Stats stats;
+};
@@ -0,0 +1,46 @@
+#include "draw-sort.h"
+
+#include <algorithm>
+#include <array>
+
+uint64_t packDrawSortKey(uint32_t pipeline, uint32_t material, float depth) {
+    const uint32_t depthMax = (1u << kDrawSortDepthBits) - 1;
+    // 写成 !(depth > 0) 让 NaN 也落到 0
+    float clamped = !(depth > 0.0f) ? 0.0f : std::min(depth, 1.0f);
+    uint64_t quantized = static_cast<uint64_t>(clamped * static_cast<float>(depthMax) + 0.5f);
+    uint64_t key = static_cast<uint64_t>(pipeline & ((1u << kDrawSortPipelineBits) - 1)) << (kDrawSortMaterialBits + kDrawSortDepthBits);
+    key |= static_cast<uint64_t>(material & ((1u << kDrawSortMaterialBits) - 1)) << kDrawSortDepthBits;
+    return key | std::min<uint64_t>(quantized, depthMax);
+}
+
+void radixSortDrawItems(std::vector<DrawSortItem>& items) {
+    if (items.size() < 2) {
+        return;
+    }
+    // 一次遍历得到全部 8 个字节的直方图
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    for (const DrawSortItem& item : items) {
+        for (uint32_t pass = 0; pass < 8; ++pass) {
+            ++histograms[pass][(item.key >> (8 * pass)) & 0xFF];
+        }
+    }
+
+    std::vector<DrawSortItem> scratch(items.size());
+    const uint32_t count = static_cast<uint32_t>(items.size());
+    for (uint32_t pass = 0; pass < 8; ++pass) {
+        std::array<uint32_t, 256>& histogram = histograms[pass];
+        if (histogram[(items[0].key >> (8 * pass)) & 0xFF] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram) {
+            uint32_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (const DrawSortItem& item : items) {
+            scratch[histogram[(item.key >> (8 * pass)) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
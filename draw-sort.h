@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 不透明绘制的排序：每个 draw 打包成一个 64 位的键，按键从小到大提交。
+//   [63:48] pipeline   16 位，换 pipeline 最贵，放最高位，同一个 pipeline 的 draw 排在一起
+//   [47:24] material   24 位，bind group / 顶点、索引 buffer 等绘制状态（本例里是 LOD 级别）
+//   [23:0]  depth      24 位，[0, 1] 量化后的深度，同状态内由近到远，深度测试尽早剔掉被挡住的片段
+// 半透明的绘制要由远到近，不能用这个键。
+
+constexpr uint32_t kDrawSortPipelineBits = 16;
+constexpr uint32_t kDrawSortMaterialBits = 24;
+constexpr uint32_t kDrawSortDepthBits = 24;
+
+// pipeline / material 超出位宽时截断（只影响分组，不影响正确性）；depth 夹到 [0, 1]
+uint64_t packDrawSortKey(uint32_t pipeline, uint32_t material, float depth);
+
+struct DrawSortItem {
+    uint64_t key = 0;
+    uint32_t index = 0;     // 调用方的 draw 编号
+};
+
+// LSD 基数排序，每趟 8 位，稳定；所有键在某一字节上都相同的那一趟直接跳过（通常只剩两三趟）
+void radixSortDrawItems(std::vector<DrawSortItem>& items);
@@ -0,0 +1,143 @@
+#include "file-watcher.h"
+
+#include <iostream>
+#include <chrono>
+
+#if defined(__linux__)
+#  include <sys/inotify.h>
+#  include <poll.h>
+#  include <unistd.h>
+#  include <climits>
+#elif !defined(__EMSCRIPTEN__)
+#  include <filesystem>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+std::string DirectoryOf(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+#elif !defined(__EMSCRIPTEN__)
+long long ModifiedTime(const std::string& path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? -1 : static_cast<long long>(time.time_since_epoch().count());
+}
+#endif
+
+} // namespace
+
+
+FileWatcher::FileWatcher() {
+#if defined(__linux__)
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0 || pipe(wakePipe) != 0) {
+        std::cout << "FileWatcher: inotify unavailable" << std::endl;
+        return;
+    }
+#elif defined(__EMSCRIPTEN__)
+    return;
+#endif
+    running = true;
+    worker = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    running = false;
+#if defined(__linux__)
+    if (wakePipe[1] >= 0) {
+        char byte = 0;
+        (void)write(wakePipe[1], &byte, 1);
+    }
+#else
+    wakeUp.notify_all();
+#endif
+    if (worker.joinable()) {
+        worker.join();
+    }
+#if defined(__linux__)
+    for (int fd : { inotifyFd, wakePipe[0], wakePipe[1] }) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool FileWatcher::Watch(const std::string& path) {
+    if (!running) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    files.insert(path);
+#if defined(__linux__)
+    std::string dir = DirectoryOf(path);
+    for (const auto& it : watchedDirs) {
+        if (it.second == dir) {
+            return true;
+        }
+    }
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        std::cout << "FileWatcher: could not watch " << dir << std::endl;
+        files.erase(path);
+        return false;
+    }
+    watchedDirs[wd] = dir;
+#else
+    modifiedTimes[path] = ModifiedTime(path);
+#endif
+    return true;
+}
+
+std::vector<std::string> FileWatcher::TakeChanged() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> result(changed.begin(), changed.end());
+    changed.clear();
+    return result;
+}
+
+void FileWatcher::MarkChanged(const std::string& path) {
+    // 调用方已持锁
+    if (files.count(path) > 0) {
+        changed.insert(path);
+    }
+}
+
+void FileWatcher::Run() {
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    while (running) {
+        pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN)) {
+            continue; // 被唤醒时 running 已经是 false
+        }
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (char* p = buffer; p < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                auto dir = watchedDirs.find(event->wd);
+                if (dir != watchedDirs.end() && event->len > 0) {
+                    MarkChanged(dir->second + "/" + event->name);
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#elif !defined(__EMSCRIPTEN__)
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wakeUp.wait_for(lock, std::chrono::milliseconds(250));
+        for (auto& it : modifiedTimes) {
+            long long time = ModifiedTime(it.first);
+            if (time != it.second) {
+                it.second = time;
+                MarkChanged(it.first);
+            }
+        }
+    }
+#endif
+}
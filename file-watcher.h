@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+// 监视若干文件是否被修改。Linux 上用 inotify 监视所在目录（编辑器常用“写临时文件再 rename”的方式保存，
+// 直接监视文件本身会丢事件），其它平台按修改时间轮询；等待都在后台线程上，不占渲染线程。
+// emscripten 下没有线程也没有本地文件，Watch() 直接返回 false。
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Watch(const std::string& path);
+    // 取出上次调用以来被修改过的文件（去重），没有则为空
+    std::vector<std::string> TakeChanged();
+
+private:
+    void Run();
+    void MarkChanged(const std::string& path);
+
+private:
+    std::mutex mutex;
+    std::set<std::string> files;        // 被监视的文件
+    std::set<std::string> changed;
+    std::atomic<bool> running{ false };
+    std::thread worker;
+#if defined(__linux__)
+    int inotifyFd = -1;
+    int wakePipe[2] = { -1, -1 };       // 析构时写一个字节唤醒阻塞在 poll 上的线程
+    std::map<int, std::string> watchedDirs; // inotify watch descriptor -> 目录
+#else
+    std::condition_variable wakeUp;
+    std::map<std::string, long long> modifiedTimes;
+#endif
+};
@@ -0,0 +1,3 @@
+// WebGPU-C++ 是 header-only 的，实现部分只在这一个编译单元里展开，App 与 Bench 共用
+#define WEBGPU_CPP_IMPLEMENTATION
+#include <webgpu/webgpu.hpp>
@@ -0,0 +1,102 @@
+#include "index-buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 按三角形贪心切段：加入下一个三角形后顶点编号跨度超出 Uint16 就另起一段。
+// draws 的 firstIndex 加上 indexOffset；放不进 Uint16（或超过 maxSplits 段）时返回 false
+bool splitUint16(const uint32_t* indices, uint32_t indexCount, uint32_t indexOffset, uint32_t vertexCount,
+                 uint32_t maxSplits, std::vector<IndexedDraw>& draws) {
+    if (vertexCount <= kMaxUint16Vertices) {
+        draws.push_back(IndexedDraw{ indexCount, indexOffset, 0 });
+        return true;
+    }
+    const size_t firstDraw = draws.size();
+    uint32_t lower = 0;
+    uint32_t upper = 0;
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        uint32_t triangleLower = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+        uint32_t triangleUpper = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+        if (draws.size() > firstDraw && std::max(upper, triangleUpper) - std::min(lower, triangleLower) < kMaxUint16Vertices) {
+            lower = std::min(lower, triangleLower);
+            upper = std::max(upper, triangleUpper);
+            draws.back().indexCount += 3;
+            continue;
+        }
+        // 一个三角形本身就放不进 Uint16；或者段太多，每多一段多一次 draw，不划算了
+        if (triangleUpper - triangleLower >= kMaxUint16Vertices || draws.size() - firstDraw >= maxSplits) {
+            return false;
+        }
+        lower = triangleLower;
+        upper = triangleUpper;
+        draws.push_back(IndexedDraw{ 3, indexOffset + i, 0 });
+    }
+    if (draws.size() == firstDraw) {
+        draws.push_back(IndexedDraw{ 0, indexOffset, 0 });
+    }
+    // 每段的 baseVertex 取段内最小的顶点编号
+    for (size_t d = firstDraw; d < draws.size(); ++d) {
+        const uint32_t* begin = indices + (draws[d].firstIndex - indexOffset);
+        draws[d].baseVertex = draws[d].indexCount > 0 ? static_cast<int32_t>(*std::min_element(begin, begin + draws[d].indexCount)) : 0;
+    }
+    return true;
+}
+
+} // namespace
+
+
+IndexBufferData buildIndexBuffer(const std::vector<const std::vector<uint32_t>*>& levels, uint32_t vertexCount, uint32_t maxSplits) {
+    IndexBufferData result;
+    std::vector<uint32_t> offsets;
+    for (const std::vector<uint32_t>* level : levels) {
+        offsets.push_back(result.indexCount);
+        result.indexCount += static_cast<uint32_t>(level->size());
+    }
+
+    bool fits = true;
+    for (size_t l = 0; fits && l < levels.size(); ++l) {
+        result.levelFirstDraw.push_back(static_cast<uint32_t>(result.draws.size()));
+        fits = splitUint16(levels[l]->data(), static_cast<uint32_t>(levels[l]->size()), offsets[l], vertexCount,
+                           std::max(maxSplits, 1u), result.draws);
+    }
+
+    if (!fits) {
+        // 任何一级放不进 Uint16 就都用 Uint32，整个 buffer 只有一种格式
+        result.format = wgpu::IndexFormat::Uint32;
+        result.draws.clear();
+        result.levelFirstDraw.clear();
+        result.data.resize(result.indexCount * sizeof(uint32_t));
+        uint32_t* target = reinterpret_cast<uint32_t*>(result.data.data());
+        for (size_t l = 0; l < levels.size(); ++l) {
+            result.levelFirstDraw.push_back(static_cast<uint32_t>(l));
+            result.draws.push_back(IndexedDraw{ static_cast<uint32_t>(levels[l]->size()), offsets[l], 0 });
+            if (!levels[l]->empty()) {
+                std::memcpy(target + offsets[l], levels[l]->data(), levels[l]->size() * sizeof(uint32_t));
+            }
+        }
+    } else {
+        result.format = wgpu::IndexFormat::Uint16;
+        result.data.assign(((result.indexCount * sizeof(uint16_t)) + 3) & ~size_t(3), 0);
+        uint16_t* target = reinterpret_cast<uint16_t*>(result.data.data());
+        for (size_t l = 0; l < levels.size(); ++l) {
+            uint32_t endDraw = l + 1 < levels.size() ? result.levelFirstDraw[l + 1] : static_cast<uint32_t>(result.draws.size());
+            for (uint32_t d = result.levelFirstDraw[l]; d < endDraw; ++d) {
+                const IndexedDraw& draw = result.draws[d];
+                for (uint32_t i = draw.firstIndex; i < draw.firstIndex + draw.indexCount; ++i) {
+                    target[i] = static_cast<uint16_t>((*levels[l])[i - offsets[l]] - draw.baseVertex);
+                }
+            }
+        }
+    }
+    if (result.draws.empty()) {
+        result.draws.push_back(IndexedDraw{});
+    }
+    result.levelFirstDraw.push_back(static_cast<uint32_t>(result.draws.size()));
+    return result;
+}
+
+IndexBufferData buildIndexBuffer(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t maxSplits) {
+    return buildIndexBuffer(std::vector<const std::vector<uint32_t>*>{ &indices }, vertexCount, maxSplits);
+}
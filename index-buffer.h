@@ -0,0 +1,33 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// 索引格式选择：顶点不超过 65535 个时用 Uint16（索引带宽减半）；
+// 更大的网格按三角形顺序切成若干段，每段引用的顶点编号跨度不超过 65535，段内索引减去 baseVertex 后仍用 Uint16，
+// 每段一次 drawIndexed。需要超过 maxSplits 段（或单个三角形的跨度就放不下）时退回 Uint32、一次画完。
+// 网格先经 optimizeVertexFetch 按首次引用的顺序编号的话，相邻三角形的顶点编号接近，段数很少。
+
+struct IndexedDraw {
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t baseVertex = 0;
+};
+
+struct IndexBufferData {
+    wgpu::IndexFormat format = wgpu::IndexFormat::Uint16;
+    std::vector<uint8_t> data;          // 按 format 编码，尾部补 0 到 4 字节的倍数
+    std::vector<IndexedDraw> draws;     // 至少一个（没有索引时 indexCount 为 0）
+    std::vector<uint32_t> levelFirstDraw;   // 第 l 级 LOD 的 draws 为 [levelFirstDraw[l], levelFirstDraw[l + 1])
+    uint32_t indexCount = 0;
+};
+
+// 0xFFFF 留给 strip 拓扑的 primitive restart，Uint16 段内只用 0 ~ 65534
+constexpr uint32_t kMaxUint16Vertices = 65535;
+
+// maxSplits : 最多切成几段，0 或 1 表示不切分
+IndexBufferData buildIndexBuffer(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t maxSplits);
+
+// 多级 LOD 依次拼进同一个 buffer，每级各自切段；有一级需要 Uint32 时所有级都用 Uint32
+IndexBufferData buildIndexBuffer(const std::vector<const std::vector<uint32_t>*>& levels, uint32_t vertexCount, uint32_t maxSplits);
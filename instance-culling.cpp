@@ -0,0 +1,238 @@
+#include "instance-culling.h"
+#include "upload-belt.h"
+#include "shader-reflection.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const uint32_t kWorkgroupSize = 64;
+const uint32_t kInstanceStride = 6 * sizeof(uint32_t); // 与 shader 中的 instanceWords 一致
+
+// 实例按 32 位字读写（array<u32>），颜色是 4 个 unorm8，不用拆开，整个字原样复制
+const char* cullShaderSource = R"(
+struct DrawArgs {
+    indexCount : u32,
+    instanceCount : atomic<u32>,
+    firstIndex : u32,
+    baseVertex : i32,
+    firstInstance : u32,
+};
+
+struct ViewUniforms {
+    time : f32,
+    aspect : f32,
+};
+
+@group(0) @binding(0) var<uniform> uView : ViewUniforms;
+@group(0) @binding(1) var<storage, read> instances : array<u32>;
+@group(0) @binding(2) var<storage, read_write> visible : array<u32>;
+@group(0) @binding(3) var<storage, read_write> args : array<DrawArgs>;
+@group(0) @binding(4) var hiZ : texture_2d<f32>;
+
+const instanceWords = 6u;           // InstanceData : offset.xy, scale, phase, depth, color
+// 与 vs_main 的特化常量同名同默认值，Initialize 传入同一组 constants
+override orbitRadius : f32 = 0.3;
+override animate : bool = true;
+override drawCount : u32 = 1;       // 索引分段数，每段一份 DrawArgs
+
+// NDC 矩形 [lower, upper] 覆盖的区域里最远的深度。选一级让矩形最多跨 2x2 个 texel，取这 4 个的最大值；
+// 金字塔每级最后一行/列的 texel 包含了奇数边多出来的像素，所以像素 p 在第 l 级落在 min(p >> l, 该级大小 - 1)
+fn farthestDepth(lower : vec2f, upper : vec2f) -> f32 {
+    let size = textureDimensions(hiZ, 0);
+    // NDC 的 y 向上，纹理的 v 向下
+    let uvLower = vec2f(lower.x, -upper.y) * 0.5 + 0.5;
+    let uvUpper = vec2f(upper.x, -lower.y) * 0.5 + 0.5;
+    let sizeF = vec2f(size);
+    let pixelLower = vec2u(clamp(floor(uvLower * sizeF), vec2f(0.0), sizeF - 1.0));
+    let pixelUpper = vec2u(clamp(floor(uvUpper * sizeF), vec2f(0.0), sizeF - 1.0));
+    let extent = max(pixelUpper.x - pixelLower.x, pixelUpper.y - pixelLower.y) + 1u;
+    // extent 为 1 时 firstLeadingBit(0u) 是 0xffffffff，加 1 正好回到第 0 级
+    let level = min(firstLeadingBit(extent - 1u) + 1u, textureNumLevels(hiZ) - 1u);
+    let levelSize = textureDimensions(hiZ, level);
+    let texelLower = min(pixelLower >> vec2u(level), levelSize - 1u);
+    let texelUpper = min(pixelUpper >> vec2u(level), levelSize - 1u);
+    return max(max(textureLoad(hiZ, texelLower, level).r, textureLoad(hiZ, vec2u(texelUpper.x, texelLower.y), level).r),
+               max(textureLoad(hiZ, vec2u(texelLower.x, texelUpper.y), level).r, textureLoad(hiZ, texelUpper, level).r));
+}
+
+@compute @workgroup_size(64)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let count = arrayLength(&instances) / instanceWords;
+    if (id.x >= count) {
+        return;
+    }
+    let base = id.x * instanceWords;
+    let offset = vec2f(bitcast<f32>(instances[base]), bitcast<f32>(instances[base + 1u]));
+    let scale = bitcast<f32>(instances[base + 2u]);
+    let phase = bitcast<f32>(instances[base + 3u]);
+    let depth = bitcast<f32>(instances[base + 4u]);
+
+    // 与 vs_main 相同的动画：正方形中心绕实例中心转圈
+    let angle = select(0.0, uView.time, animate) + phase;
+    let centre = offset + orbitRadius * scale * vec2f(cos(angle), sin(angle));
+    // 半边长 0.5 * scale 的正方形，用外接圆做保守的视口测试
+    let radius = 0.70710678 * scale;
+    if (abs(centre.x) - radius > 1.0 || (abs(centre.y) - radius) * uView.aspect > 1.0) {
+        return;
+    }
+    // 遮挡测试：正方形整个在 depth 上，比它覆盖的区域里上一帧最远的深度还远就被挡住了
+    let lower = clamp(vec2f(centre.x - radius, (centre.y - radius) * uView.aspect), vec2f(-1.0), vec2f(1.0));
+    let upper = clamp(vec2f(centre.x + radius, (centre.y + radius) * uView.aspect), vec2f(-1.0), vec2f(1.0));
+    if (depth > farthestDepth(lower, upper)) {
+        return;
+    }
+
+    let slot = atomicAdd(&args[0].instanceCount, 1u);
+    for (var d = 1u; d < drawCount; d++) {
+        atomicAdd(&args[d].instanceCount, 1u);
+    }
+    for (var i = 0u; i < instanceWords; i++) {
+        visible[slot * instanceWords + i] = instances[base + i];
+    }
+}
+)";
+
+} // namespace
+
+
+InstanceCuller::InstanceCuller(wgpu::Device device)
+    : device(device) {
+}
+
+InstanceCuller::~InstanceCuller() {
+    if (bindGroup != nullptr) {
+        bindGroup.release();
+    }
+    if (pipeline != nullptr) {
+        pipeline.release();
+    }
+    if (layoutPipeline != nullptr) {
+        layoutPipeline.release();
+    }
+    if (layoutBindGroup != nullptr) {
+        layoutBindGroup.release();
+    }
+}
+
+bool InstanceCuller::Initialize(const BufferAllocation& instances, const BufferAllocation& visible, const BufferAllocation& args,
+                                const BufferAllocation& uniform, uint32_t instanceCount, uint32_t instanceStride, uint32_t drawCount,
+                                const std::vector<wgpu::ConstantEntry>& constants, wgpu::TextureView hiZ) {
+    if (instanceStride != kInstanceStride) {
+        std::cout << "InstanceCuller: unexpected instance stride " << instanceStride << std::endl;
+        return false;
+    }
+    this->instances = instances;
+    this->visible = visible;
+    this->args = args;
+    this->uniform = uniform;
+    this->instanceCount = instanceCount;
+    this->drawCount = std::max(drawCount, 1u);
+
+    // 0: 帧 uniform（动态偏移），1: 全部实例，2: 可见实例，3: 间接绘制参数（运行时数组，反射出的大小是一份），
+    // 4: 深度金字塔；类型与大小从 shader 反射
+    ShaderReflection reflection;
+    if (!reflection.Parse(cullShaderSource)) {
+        return false;
+    }
+    std::vector<wgpu::BindGroupLayoutEntry> layoutEntries = reflection.GetBindGroupLayoutEntries(0);
+    if (layoutEntries.size() != 5 || layoutEntries[3].buffer.minBindingSize != kDrawArgsSize) {
+        std::cout << "InstanceCuller: unexpected bindings in the culling shader" << std::endl;
+        return false;
+    }
+    layoutEntries[0].buffer.hasDynamicOffset = true;
+    layoutEntries[4].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat; // R32Float 不可过滤
+
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = cullShaderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+#ifdef WEBGPU_BACKEND_WGPU
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+#endif
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    wgpu::ShaderModule shaderModule = device.createShaderModule(shaderDesc);
+
+    wgpu::BindGroupLayoutDescriptor descGroupLayout{};
+    descGroupLayout.entryCount = layoutEntries.size();
+    descGroupLayout.entries = layoutEntries.data();
+    layoutBindGroup = device.createBindGroupLayout(descGroupLayout);
+
+    wgpu::PipelineLayoutDescriptor descPipelineLayout{};
+    descPipelineLayout.bindGroupLayoutCount = 1;
+    descPipelineLayout.bindGroupLayouts = (WGPUBindGroupLayout*)&layoutBindGroup;
+    layoutPipeline = device.createPipelineLayout(descPipelineLayout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Instance culling";
+    pipelineDesc.layout = layoutPipeline;
+    pipelineDesc.compute.module = shaderModule;
+    pipelineDesc.compute.entryPoint = "cs_main";
+    std::vector<wgpu::ConstantEntry> cullConstants = constants;
+    wgpu::ConstantEntry drawCountConstant{};
+    drawCountConstant.key = "drawCount";
+    drawCountConstant.value = this->drawCount;
+    cullConstants.push_back(drawCountConstant);
+    pipelineDesc.compute.constantCount = cullConstants.size();
+    pipelineDesc.compute.constants = cullConstants.data();
+    pipeline = device.createComputePipeline(pipelineDesc);
+    shaderModule.release();
+    return pipeline != nullptr && SetDepthPyramid(hiZ);
+}
+
+bool InstanceCuller::SetDepthPyramid(wgpu::TextureView hiZ) {
+    if (bindGroup != nullptr) {
+        bindGroup.release();
+    }
+    std::vector<wgpu::BindGroupEntry> entries(5, wgpu::Default);
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        entries[i].binding = i;
+    }
+    entries[0].buffer = uniform.buffer;
+    entries[0].offset = uniform.offset;
+    entries[0].size = 4 * sizeof(float);
+    entries[1].buffer = instances.buffer;
+    entries[1].offset = instances.offset;
+    entries[1].size = static_cast<uint64_t>(instanceCount) * kInstanceStride;
+    entries[2].buffer = visible.buffer;
+    entries[2].offset = visible.offset;
+    entries[2].size = static_cast<uint64_t>(instanceCount) * kInstanceStride;
+    entries[3].buffer = args.buffer;
+    entries[3].offset = args.offset;
+    entries[3].size = drawCount * kDrawArgsSize;
+    entries[4].textureView = hiZ;
+
+    wgpu::BindGroupDescriptor descBindGroup{};
+    descBindGroup.layout = layoutBindGroup;
+    descBindGroup.entryCount = entries.size();
+    descBindGroup.entries = entries.data();
+    bindGroup = device.createBindGroup(descBindGroup);
+    return bindGroup != nullptr;
+}
+
+void InstanceCuller::Record(wgpu::CommandEncoder encoder, UploadBelt& belt, const std::vector<IndexedDraw>& draws, uint32_t uniformOffset) {
+    // 可见实例数每帧从 0 开始累计
+    uint32_t* drawArgs = (uint32_t*)belt.Write(encoder, args.buffer, args.offset, drawCount * kDrawArgsSize);
+    for (uint32_t i = 0; i < drawCount; ++i, drawArgs += 5) {
+        const IndexedDraw draw = i < draws.size() ? draws[i] : IndexedDraw{};
+        drawArgs[0] = draw.indexCount;
+        drawArgs[1] = 0;
+        drawArgs[2] = draw.firstIndex;
+        drawArgs[3] = static_cast<uint32_t>(draw.baseVertex);
+        drawArgs[4] = 0;
+    }
+
+    wgpu::ComputePassDescriptor passDesc;
+    passDesc.label = "Instance culling pass";
+    passDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass(passDesc);
+    computePass.setPipeline(pipeline);
+    computePass.setBindGroup(0, bindGroup, 1, &uniformOffset);
+    computePass.dispatchWorkgroups((instanceCount + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1);
+    computePass.end();
+    computePass.release();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "buffer-allocator.h"
+#include "index-buffer.h"
+
+#include <vector>
+
+class UploadBelt;
+
+// GPU 端的实例可见性剔除：compute pass 逐实例做视口测试，再拿上一帧的深度金字塔（DepthPyramid）做遮挡测试，
+// 把可见的实例紧凑地写进 visible，同时用原子加累计 DrawIndexedIndirect 参数里的 instanceCount，
+// render pass 用 drawIndexedIndirect 消费。网格的索引切成多段时每段一份参数，实例数相同。
+// 这样 CPU 每帧只录固定的几条命令，与实例个数无关。
+// 遮挡测试用的是上一帧的深度：遮挡物移开后，被挡住的实例要晚一帧才出现。
+class InstanceCuller {
+public:
+    // DrawIndexedIndirect 参数：indexCount, instanceCount, firstIndex, baseVertex, firstInstance
+    static constexpr uint64_t kDrawArgsSize = 5 * sizeof(uint32_t);
+
+    explicit InstanceCuller(wgpu::Device device);
+    ~InstanceCuller();
+
+    InstanceCuller(const InstanceCuller&) = delete;
+    InstanceCuller& operator=(const InstanceCuller&) = delete;
+
+    // instances : 全部实例（只读 storage），每个实例 instanceStride 字节（须为 Application::InstanceData 的 24 字节布局）
+    // visible   : 剔除后的实例，与 instances 同样大（storage + vertex）
+    // args      : drawCount * kDrawArgsSize 字节（storage + indirect），每个 IndexedDraw 一份
+    // uniform   : 帧 uniform，绑定时用动态偏移选中本帧那一份：time, aspect
+    // constants : 与 vs_main 相同的特化常量（orbitRadius, animate），保证剔除用的是同样的动画
+    // hiZ       : DepthPyramid::GetView()，全是 1.0 时不剔除任何东西
+    // 各 offset 需按 minStorageBufferOffsetAlignment / minUniformBufferOffsetAlignment 对齐
+    bool Initialize(const BufferAllocation& instances, const BufferAllocation& visible, const BufferAllocation& args,
+                    const BufferAllocation& uniform, uint32_t instanceCount, uint32_t instanceStride, uint32_t drawCount,
+                    const std::vector<wgpu::ConstantEntry>& constants, wgpu::TextureView hiZ);
+    // 深度金字塔随渲染目标重建后调用，换掉 bind group 里的纹理
+    bool SetDepthPyramid(wgpu::TextureView hiZ);
+
+    // 录制到 encoder：先经上传带把每份 args 重置为 { indexCount, 0, firstIndex, baseVertex, 0 }，再 dispatch 剔除
+    void Record(wgpu::CommandEncoder encoder, UploadBelt& belt, const std::vector<IndexedDraw>& draws, uint32_t uniformOffset);
+
+private:
+    wgpu::Device device = nullptr;
+    wgpu::ComputePipeline pipeline = nullptr;
+    wgpu::BindGroupLayout layoutBindGroup = nullptr;
+    wgpu::PipelineLayout layoutPipeline = nullptr;
+    wgpu::BindGroup bindGroup = nullptr;
+    BufferAllocation instances;
+    BufferAllocation visible;
+    BufferAllocation args;
+    BufferAllocation uniform;
+    uint32_t instanceCount = 0;
+    uint32_t drawCount = 1;
+};
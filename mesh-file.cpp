@@ -0,0 +1,280 @@
+#include "mesh-file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+
+const char kMeshFileMagic[4] = { 'L', 'W', 'G', 'M' };
+
+uint64_t alignUp(uint64_t value) {
+    return (value + kMeshFileAlignment - 1) & ~(kMeshFileAlignment - 1);
+}
+
+bool sectionInside(const MeshFileSection& section, uint64_t fileSize) {
+    return section.offset % kMeshFileAlignment == 0 && section.offset <= fileSize && section.size <= fileSize - section.offset;
+}
+
+// 被 [firstIndex, firstIndex + indexCount) 引用的顶点的包围盒
+void submeshBounds(const Mesh& mesh, const IndexedDraw& draw, const IndexBufferData& indices, float lower[3], float upper[3]) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        lower[axis] = std::numeric_limits<float>::max();
+        upper[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (uint32_t i = draw.firstIndex; i < draw.firstIndex + draw.indexCount; ++i) {
+        uint32_t index = 0;
+        if (indices.format == wgpu::IndexFormat::Uint16) {
+            uint16_t value;
+            std::memcpy(&value, indices.data.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+            index = value;
+        } else {
+            std::memcpy(&index, indices.data.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+        }
+        const float* position = mesh.vertices[index + draw.baseVertex].position;
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            lower[axis] = std::min(lower[axis], position[axis]);
+            upper[axis] = std::max(upper[axis], position[axis]);
+        }
+    }
+}
+
+} // namespace
+
+
+MappedMeshFile::~MappedMeshFile() {
+    Close();
+}
+
+bool MappedMeshFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER fileSize{};
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+        std::cout << "MappedMeshFile: could not open " << path << std::endl;
+        return false;
+    }
+    file = fileHandle;
+    mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info{};
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::cout << "MappedMeshFile: could not open " << path << std::endl;
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 映射建立后不再需要文件描述符
+    if (mapped != MAP_FAILED) {
+        data = static_cast<const uint8_t*>(mapped);
+#  ifdef MADV_SEQUENTIAL
+        madvise(mapped, size, MADV_SEQUENTIAL); // 各段按顺序整段读，让内核积极预读
+#  endif
+    }
+#endif
+    if (data == nullptr) {
+        std::cout << "MappedMeshFile: could not map " << path << std::endl;
+        Close();
+        return false;
+    }
+    if (!Validate(path)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedMeshFile::Close() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    file = nullptr;
+    mapping = nullptr;
+#else
+    if (data != nullptr) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedMeshFile::Validate(const std::string& path) const {
+    auto fail = [&path](const char* message) {
+        std::cout << "MappedMeshFile: " << path << ": " << message << std::endl;
+        return false;
+    };
+    if (size < sizeof(MeshFileHeader)) {
+        return fail("file too small");
+    }
+    const MeshFileHeader& header = GetHeader();
+    if (std::memcmp(header.magic, kMeshFileMagic, sizeof(kMeshFileMagic)) != 0) {
+        return fail("not a mesh file");
+    }
+    if (header.version != kMeshFileVersion || header.headerSize != sizeof(MeshFileHeader)) {
+        return fail("unsupported version, re-export the mesh");
+    }
+    if (header.positionEncoding > static_cast<uint32_t>(PositionEncoding::Unorm16)
+        || header.colorEncoding > static_cast<uint32_t>(ColorEncoding::Unorm8)
+        || (header.positionComponents != 2 && header.positionComponents != 3)
+        || (header.indexSize != 2 && header.indexSize != 4)) {
+        return fail("invalid vertex or index format");
+    }
+    if (!sectionInside(header.vertices, size) || !sectionInside(header.indices, size) || !sectionInside(header.submeshes, size)
+        || !sectionInside(header.lods, size)) {
+        return fail("section out of range");
+    }
+    if (header.vertexStride != GetVertexEncoding().GetStride()
+        || header.vertices.size != static_cast<uint64_t>(header.vertexCount) * header.vertexStride
+        || header.indices.size < static_cast<uint64_t>(header.indexCount) * header.indexSize
+        || header.indices.size % 4 != 0
+        || header.submeshCount == 0
+        || header.submeshes.size != static_cast<uint64_t>(header.submeshCount) * sizeof(MeshFileSubmesh)
+        || header.lodCount == 0
+        || header.lods.size != static_cast<uint64_t>(header.lodCount) * sizeof(MeshFileLod)) {
+        return fail("section sizes do not match the header");
+    }
+    const MeshFileSubmesh* submeshes = GetSubmeshes();
+    for (uint32_t i = 0; i < header.submeshCount; ++i) {
+        if (submeshes[i].firstIndex > header.indexCount || submeshes[i].indexCount > header.indexCount - submeshes[i].firstIndex) {
+            return fail("submesh out of range");
+        }
+    }
+    const MeshFileLod* lods = GetLods();
+    for (uint32_t i = 0; i < header.lodCount; ++i) {
+        if (lods[i].firstSubmesh > header.submeshCount || lods[i].submeshCount > header.submeshCount - lods[i].firstSubmesh) {
+            return fail("lod out of range");
+        }
+    }
+    return true;
+}
+
+VertexEncoding MappedMeshFile::GetVertexEncoding() const {
+    const MeshFileHeader& header = GetHeader();
+    VertexEncoding encoding;
+    encoding.position = static_cast<PositionEncoding>(header.positionEncoding);
+    encoding.color = static_cast<ColorEncoding>(header.colorEncoding);
+    encoding.positionComponents = header.positionComponents;
+    return encoding;
+}
+
+Dequantization MappedMeshFile::GetDequantization() const {
+    const MeshFileHeader& header = GetHeader();
+    Dequantization dequantization;
+    std::memcpy(dequantization.scale, header.dequantizationScale, sizeof(dequantization.scale));
+    std::memcpy(dequantization.offset, header.dequantizationOffset, sizeof(dequantization.offset));
+    return dequantization;
+}
+
+wgpu::IndexFormat MappedMeshFile::GetIndexFormat() const {
+    return GetHeader().indexSize == 2 ? wgpu::IndexFormat::Uint16 : wgpu::IndexFormat::Uint32;
+}
+
+std::vector<IndexedDraw> MappedMeshFile::GetDraws() const {
+    std::vector<IndexedDraw> draws;
+    const MeshFileSubmesh* submeshes = GetSubmeshes();
+    for (uint32_t i = 0; i < GetHeader().submeshCount; ++i) {
+        draws.push_back(IndexedDraw{ submeshes[i].indexCount, submeshes[i].firstIndex, submeshes[i].baseVertex });
+    }
+    return draws;
+}
+
+
+bool writeMeshFile(const std::string& path, const Mesh& mesh, const CompressedVertices& vertices, const IndexBufferData& indices) {
+    MeshFileHeader header{};
+    std::memcpy(header.magic, kMeshFileMagic, sizeof(kMeshFileMagic));
+    header.version = kMeshFileVersion;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.positionEncoding = static_cast<uint32_t>(vertices.encoding.position);
+    header.colorEncoding = static_cast<uint32_t>(vertices.encoding.color);
+    header.positionComponents = vertices.encoding.positionComponents;
+    header.vertexStride = vertices.encoding.GetStride();
+    header.vertexCount = vertices.vertexCount;
+    header.indexSize = indices.format == wgpu::IndexFormat::Uint16 ? 2 : 4;
+    header.indexCount = indices.indexCount;
+    header.submeshCount = static_cast<uint32_t>(indices.draws.size());
+    header.lodCount = static_cast<uint32_t>(indices.levelFirstDraw.size() - 1);
+    std::memcpy(header.dequantizationScale, vertices.dequantization.scale, sizeof(header.dequantizationScale));
+    std::memcpy(header.dequantizationOffset, vertices.dequantization.offset, sizeof(header.dequantizationOffset));
+
+    std::vector<MeshFileSubmesh> submeshes;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        header.boundsMin[axis] = std::numeric_limits<float>::max();
+        header.boundsMax[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (const IndexedDraw& draw : indices.draws) {
+        MeshFileSubmesh submesh{ draw.firstIndex, draw.indexCount, draw.baseVertex, 0, {}, {} };
+        submeshBounds(mesh, draw, indices, submesh.boundsMin, submesh.boundsMax);
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            header.boundsMin[axis] = std::min(header.boundsMin[axis], submesh.boundsMin[axis]);
+            header.boundsMax[axis] = std::max(header.boundsMax[axis], submesh.boundsMax[axis]);
+        }
+        submeshes.push_back(submesh);
+    }
+    std::vector<MeshFileLod> lods;
+    for (uint32_t level = 0; level < header.lodCount; ++level) {
+        float error = level > 0 && level <= mesh.lods.size() ? mesh.lods[level - 1].error : 0.0f;
+        lods.push_back(MeshFileLod{ indices.levelFirstDraw[level],
+                                    indices.levelFirstDraw[level + 1] - indices.levelFirstDraw[level], error, 0 });
+    }
+
+    header.vertices = { alignUp(sizeof(MeshFileHeader)), vertices.data.size() };
+    header.indices = { alignUp(header.vertices.offset + header.vertices.size), indices.data.size() };
+    header.submeshes = { alignUp(header.indices.offset + header.indices.size), submeshes.size() * sizeof(MeshFileSubmesh) };
+    header.lods = { alignUp(header.submeshes.offset + header.submeshes.size), lods.size() * sizeof(MeshFileLod) };
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "writeMeshFile: could not create " << path << std::endl;
+        return false;
+    }
+    auto writeSection = [&file](const MeshFileSection& section, const void* bytes) {
+        static const char padding[kMeshFileAlignment] = {};
+        file.write(padding, section.offset - static_cast<uint64_t>(file.tellp()));
+        file.write(static_cast<const char*>(bytes), section.size);
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSection(header.vertices, vertices.data.data());
+    writeSection(header.indices, indices.data.data());
+    writeSection(header.submeshes, submeshes.data());
+    writeSection(header.lods, lods.data());
+    if (!file) {
+        std::cout << "writeMeshFile: could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "mesh.h"
+#include "vertex-compression.h"
+#include "index-buffer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 二进制网格文件（.lwgm）：存的是已经处理好的、可以直接上传的数据（压缩后的顶点、选好格式的索引、分段表），
+// 加载时 mmap 整个文件，校验头部后各段数据原样交给上传带，没有解析也没有中间拷贝。
+//
+//   MeshFileHeader | 顶点段 | 索引段 | 子网格表 | LOD 表      各段起点按 kMeshFileAlignment 对齐
+//
+// 各级 LOD 共用顶点段，索引依次拼在索引段里；LOD 表的每一项是子网格表里连续的一段。
+//
+// 所有字段为小端；版本号不同直接拒绝，格式变了就升版本重新导出。
+constexpr uint32_t kMeshFileVersion = 2;
+constexpr uint64_t kMeshFileAlignment = 16;
+
+struct MeshFileSection {
+    uint64_t offset;            // 相对文件开头
+    uint64_t size;
+};
+
+struct MeshFileHeader {
+    char magic[4];              // "LWGM"
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(MeshFileHeader)
+    uint32_t flags;             // 保留，目前为 0
+
+    uint32_t positionEncoding;  // PositionEncoding
+    uint32_t colorEncoding;     // ColorEncoding
+    uint32_t positionComponents;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexSize;         // 每个索引的字节数：2 或 4
+    uint32_t indexCount;
+    uint32_t submeshCount;
+    uint32_t lodCount;          // 至少 1（LOD 0）
+    uint32_t reserved;
+
+    float boundsMin[3];         // 未量化的位置的包围盒
+    float boundsMax[3];
+    float dequantizationScale[3];
+    float dequantizationOffset[3];
+
+    MeshFileSection vertices;
+    MeshFileSection indices;
+    MeshFileSection submeshes;  // submeshCount 个 MeshFileSubmesh
+    MeshFileSection lods;       // lodCount 个 MeshFileLod
+};
+static_assert(sizeof(MeshFileHeader) == 168, "MeshFileHeader layout changed, bump kMeshFileVersion");
+
+// 对应一个 IndexedDraw，附带它引用的顶点的包围盒
+struct MeshFileSubmesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t baseVertex;
+    uint32_t reserved;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+static_assert(sizeof(MeshFileSubmesh) == 40, "MeshFileSubmesh layout changed, bump kMeshFileVersion");
+
+struct MeshFileLod {
+    uint32_t firstSubmesh;
+    uint32_t submeshCount;
+    float error;                // 相对 LOD 0 的几何误差，未量化的坐标单位
+    uint32_t reserved;
+};
+static_assert(sizeof(MeshFileLod) == 16, "MeshFileLod layout changed, bump kMeshFileVersion");
+
+// 只读映射一个 .lwgm 文件；返回的指针都指向映射内存，在对象销毁前有效
+class MappedMeshFile {
+public:
+    MappedMeshFile() = default;
+    ~MappedMeshFile();
+
+    MappedMeshFile(const MappedMeshFile&) = delete;
+    MappedMeshFile& operator=(const MappedMeshFile&) = delete;
+
+    // 映射并校验；失败时打印原因并返回 false
+    bool Open(const std::string& path);
+    void Close();
+
+    const MeshFileHeader& GetHeader() const { return *reinterpret_cast<const MeshFileHeader*>(data); }
+    VertexEncoding GetVertexEncoding() const;
+    Dequantization GetDequantization() const;
+    wgpu::IndexFormat GetIndexFormat() const;
+    std::vector<IndexedDraw> GetDraws() const;
+
+    const uint8_t* GetVertexData() const { return data + GetHeader().vertices.offset; }
+    const uint8_t* GetIndexData() const { return data + GetHeader().indices.offset; }
+    const MeshFileSubmesh* GetSubmeshes() const {
+        return reinterpret_cast<const MeshFileSubmesh*>(data + GetHeader().submeshes.offset);
+    }
+    const MeshFileLod* GetLods() const {
+        return reinterpret_cast<const MeshFileLod*>(data + GetHeader().lods.offset);
+    }
+
+private:
+    bool Validate(const std::string& path) const;
+
+private:
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;       // HANDLE
+    void* mapping = nullptr;    // HANDLE
+#endif
+};
+
+// 把处理好的网格写成 .lwgm；mesh 是压缩前的网格，用来算包围盒、取各级 LOD 的误差。
+// indices.levelFirstDraw 给出 LOD 的划分
+bool writeMeshFile(const std::string& path, const Mesh& mesh, const CompressedVertices& vertices, const IndexBufferData& indices);
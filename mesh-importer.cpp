@@ -0,0 +1,871 @@
+#include "mesh-importer.h"
+#include "webgpu-utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string lowerExtension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? std::string() : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension;
+}
+
+// 按值合并相同的顶点；remap 先按源顶点编号去重，同一个源顶点只查一次哈希表
+struct VertexHash {
+    size_t operator()(const Mesh::Vertex& vertex) const {
+        return static_cast<size_t>(hashFnv1a(&vertex, sizeof(vertex)));
+    }
+};
+
+struct VertexEqual {
+    bool operator()(const Mesh::Vertex& a, const Mesh::Vertex& b) const {
+        return std::memcmp(&a, &b, sizeof(Mesh::Vertex)) == 0;
+    }
+};
+
+void deduplicate(const std::vector<Mesh::Vertex>& sourceVertices, const std::vector<uint32_t>& sourceIndices, Mesh& mesh) {
+    const uint32_t unset = ~0u;
+    std::vector<uint32_t> remap(sourceVertices.size(), unset);
+    std::unordered_map<Mesh::Vertex, uint32_t, VertexHash, VertexEqual> unique;
+    unique.reserve(sourceVertices.size());
+    mesh.vertices.clear();
+    mesh.indices.resize(sourceIndices.size());
+    for (size_t i = 0; i < sourceIndices.size(); ++i) {
+        uint32_t source = sourceIndices[i];
+        if (remap[source] == unset) {
+            auto inserted = unique.emplace(sourceVertices[source], static_cast<uint32_t>(mesh.vertices.size()));
+            if (inserted.second) {
+                mesh.vertices.push_back(sourceVertices[source]);
+            }
+            remap[source] = inserted.first->second;
+        }
+        mesh.indices[i] = remap[source];
+    }
+}
+
+const Mesh::Vertex kDefaultVertex = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+
+
+// ---------------------------------------------------------------- OBJ
+
+// 面里的顶点引用：正数是全局编号（从 1 开始），负数相对当前已出现的顶点数，跨块时要加上前面各块的顶点数
+struct ObjReference {
+    int64_t value;
+    bool relative;
+};
+
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<ObjReference> triangles;
+    std::string error;
+};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+void skipBlanks(const char*& p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+}
+
+// 只在本行内读数：strtof/strtoll 会跳过换行，先确认下一个字符还在行内
+bool parseFloat(const char*& p, const char* lineEnd, float& value) {
+    skipBlanks(p, lineEnd);
+    if (p >= lineEnd) {
+        return false;
+    }
+    char* next = nullptr;
+    value = std::strtof(p, &next);
+    if (next == p || next > lineEnd) {
+        return false;
+    }
+    p = next;
+    return true;
+}
+
+void parseObjChunk(ObjChunk& chunk) {
+    std::vector<ObjReference> polygon;
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', chunk.end - line));
+        lineEnd = lineEnd != nullptr ? lineEnd : chunk.end;
+        const char* p = line;
+        line = lineEnd + 1;
+        skipBlanks(p, lineEnd);
+        if (lineEnd - p < 2 || !isBlank(p[1])) {
+            continue; // 空行、注释、vn / vt / o / g / usemtl ...
+        }
+
+        if (p[0] == 'v') {
+            ++p;
+            float values[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+            uint32_t count = 0;
+            while (count < 6 && parseFloat(p, lineEnd, values[count])) {
+                ++count;
+            }
+            if (count < 3) {
+                chunk.error = "vertex with fewer than 3 coordinates";
+                return;
+            }
+            Mesh::Vertex vertex = kDefaultVertex;
+            std::memcpy(vertex.position, values, sizeof(vertex.position));
+            if (count == 6) {
+                std::memcpy(vertex.color, values + 3, sizeof(vertex.color));
+            }
+            chunk.vertices.push_back(vertex);
+        } else if (p[0] == 'f') {
+            ++p;
+            polygon.clear();
+            while (true) {
+                skipBlanks(p, lineEnd);
+                if (p >= lineEnd || *p == '\r') {
+                    break;
+                }
+                char* next = nullptr;
+                long long index = std::strtoll(p, &next, 10);
+                if (next == p || next > lineEnd || index == 0) {
+                    chunk.error = "invalid face";
+                    return;
+                }
+                // 负索引相对于到此为止出现过的顶点
+                polygon.push_back(index > 0 ? ObjReference{ index - 1, false }
+                                            : ObjReference{ static_cast<int64_t>(chunk.vertices.size()) + index, true });
+                p = next;
+                while (p < lineEnd && !isBlank(*p) && *p != '\r') {
+                    ++p; // 跳过 /vt/vn
+                }
+            }
+            if (polygon.size() < 3) {
+                chunk.error = "face with fewer than 3 vertices";
+                return;
+            }
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                chunk.triangles.push_back(polygon[0]);
+                chunk.triangles.push_back(polygon[i]);
+                chunk.triangles.push_back(polygon[i + 1]);
+            }
+        }
+    }
+}
+
+
+// ---------------------------------------------------------------- glTF
+
+// 够 glTF 用的 JSON：解析成树，数字一律 double
+class Json {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json& operator[](const char* key) const {
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+        return Null();
+    }
+    const Json& At(size_t index) const {
+        return index < array.size() ? array[index] : Null();
+    }
+    bool Has(const char* key) const { return &(*this)[key] != &Null(); }
+    size_t Size() const { return type == Type::Array ? array.size() : object.size(); }
+    double Number(double fallback) const { return type == Type::Number ? number : fallback; }
+    int64_t Integer(int64_t fallback) const { return type == Type::Number ? static_cast<int64_t>(number) : fallback; }
+
+    static const Json& Null() {
+        static const Json null;
+        return null;
+    }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : p(begin), end(end) {}
+
+    bool Parse(Json& value) {
+        return ParseValue(value, 0) && (SkipSpaces(), p == end);
+    }
+
+private:
+    void SkipSpaces() {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+            ++p;
+        }
+    }
+
+    bool Expect(const char* literal) {
+        size_t length = std::strlen(literal);
+        if (static_cast<size_t>(end - p) < length || std::memcmp(p, literal, length) != 0) {
+            return false;
+        }
+        p += length;
+        return true;
+    }
+
+    bool ParseValue(Json& value, int depth) {
+        SkipSpaces();
+        if (p >= end || depth > 64) {
+            return false;
+        }
+        switch (*p) {
+        case '{': return ParseObject(value, depth);
+        case '[': return ParseArray(value, depth);
+        case '"': value.type = Json::Type::String; return ParseString(value.string);
+        case 't': value.type = Json::Type::Bool; value.boolean = true; return Expect("true");
+        case 'f': value.type = Json::Type::Bool; value.boolean = false; return Expect("false");
+        case 'n': value.type = Json::Type::Null; return Expect("null");
+        default: break;
+        }
+        // 数字：strtod 需要以 0 结尾，拷到小缓冲区里
+        char buffer[64];
+        size_t length = 0;
+        while (p + length < end && length + 1 < sizeof(buffer) && std::strchr("+-0123456789.eE", p[length]) != nullptr) {
+            buffer[length] = p[length];
+            ++length;
+        }
+        buffer[length] = '\0';
+        char* last = nullptr;
+        value.type = Json::Type::Number;
+        value.number = std::strtod(buffer, &last);
+        if (length == 0 || last != buffer + length) {
+            return false;
+        }
+        p += length;
+        return true;
+    }
+
+    bool ParseString(std::string& text) {
+        ++p; // "
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                text += *p++;
+                continue;
+            }
+            if (++p >= end) {
+                return false;
+            }
+            char escape = *p++;
+            switch (escape) {
+            case 'n': text += '\n'; break;
+            case 't': text += '\t'; break;
+            case 'r': text += '\r'; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'u': {
+                if (end - p < 4) {
+                    return false;
+                }
+                uint32_t code = static_cast<uint32_t>(std::strtoul(std::string(p, 4).c_str(), nullptr, 16));
+                p += 4;
+                // 转成 UTF-8；代理对不合并（glTF 里的名字用不到）
+                if (code < 0x80) {
+                    text += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    text += static_cast<char>(0xC0 | (code >> 6));
+                    text += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    text += static_cast<char>(0xE0 | (code >> 12));
+                    text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    text += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: text += escape; break; // \" \\ \/
+            }
+        }
+        if (p >= end) {
+            return false;
+        }
+        ++p;
+        return true;
+    }
+
+    bool ParseArray(Json& value, int depth) {
+        value.type = Json::Type::Array;
+        ++p; // [
+        SkipSpaces();
+        if (p < end && *p == ']') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            value.array.emplace_back();
+            if (!ParseValue(value.array.back(), depth + 1)) {
+                return false;
+            }
+            SkipSpaces();
+            if (p < end && *p == ',') {
+                ++p;
+            } else {
+                return Expect("]");
+            }
+        }
+    }
+
+    bool ParseObject(Json& value, int depth) {
+        value.type = Json::Type::Object;
+        ++p; // {
+        SkipSpaces();
+        if (p < end && *p == '}') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            SkipSpaces();
+            std::string key;
+            if (p >= end || *p != '"' || !ParseString(key)) {
+                return false;
+            }
+            SkipSpaces();
+            if (!Expect(":")) {
+                return false;
+            }
+            value.object.emplace_back(std::move(key), Json());
+            if (!ParseValue(value.object.back().second, depth + 1)) {
+                return false;
+            }
+            SkipSpaces();
+            if (p < end && *p == ',') {
+                ++p;
+            } else {
+                return Expect("}");
+            }
+        }
+    }
+
+private:
+    const char* p;
+    const char* end;
+};
+
+bool decodeBase64(const std::string& text, size_t begin, std::string& bytes) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    bytes.clear();
+    bytes.reserve((text.size() - begin) * 3 / 4);
+    uint32_t accumulator = 0;
+    int bits = 0;
+    for (size_t i = begin; i < text.size() && text[i] != '='; ++i) {
+        int digit = value(text[i]);
+        if (digit < 0) {
+            return false;
+        }
+        accumulator = (accumulator << 6) | static_cast<uint32_t>(digit);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            bytes += static_cast<char>((accumulator >> bits) & 0xFF);
+        }
+    }
+    return true;
+}
+
+// glTF 矩阵按列存储
+struct Matrix {
+    float m[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+    Matrix operator*(const Matrix& other) const {
+        Matrix result;
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k) {
+                    sum += m[k * 4 + row] * other.m[column * 4 + k];
+                }
+                result.m[column * 4 + row] = sum;
+            }
+        }
+        return result;
+    }
+
+    void Transform(const float in[3], float out[3]) const {
+        for (int row = 0; row < 3; ++row) {
+            out[row] = m[row] * in[0] + m[4 + row] * in[1] + m[8 + row] * in[2] + m[12 + row];
+        }
+    }
+};
+
+Matrix nodeMatrix(const Json& node) {
+    Matrix matrix;
+    const Json& values = node["matrix"];
+    if (values.Size() == 16) {
+        for (size_t i = 0; i < 16; ++i) {
+            matrix.m[i] = static_cast<float>(values.At(i).Number(matrix.m[i]));
+        }
+        return matrix;
+    }
+    // T * R * S
+    const Json& t = node["translation"];
+    const Json& r = node["rotation"];
+    const Json& s = node["scale"];
+    float x = static_cast<float>(r.At(0).Number(0.0)), y = static_cast<float>(r.At(1).Number(0.0));
+    float z = static_cast<float>(r.At(2).Number(0.0)), w = static_cast<float>(r.At(3).Number(1.0));
+    float rotation[9] = {
+        1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w),
+        2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+        2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y),
+    };
+    for (int column = 0; column < 3; ++column) {
+        float scale = static_cast<float>(s.At(column).Number(1.0));
+        for (int row = 0; row < 3; ++row) {
+            matrix.m[column * 4 + row] = rotation[column * 3 + row] * scale;
+        }
+        matrix.m[12 + column] = static_cast<float>(t.At(column).Number(0.0));
+    }
+    return matrix;
+}
+
+struct GltfDocument {
+    Json json;
+    std::vector<std::string> buffers;
+};
+
+// accessor 解析后的位置与格式；base 为 nullptr 表示没有 bufferView（规范允许：全部为 0）
+struct AccessorView {
+    uint32_t components = 0;
+    int64_t componentType = 0;
+    uint32_t componentSize = 0;
+    uint64_t count = 0;
+    uint64_t stride = 0;
+    bool normalized = false;
+    const uint8_t* base = nullptr;
+};
+
+bool resolveAccessor(const GltfDocument& document, int64_t index, AccessorView& result, std::string& error) {
+    const Json& accessor = document.json["accessors"].At(static_cast<size_t>(index));
+    if (accessor.type != Json::Type::Object) {
+        error = "missing accessor";
+        return false;
+    }
+    if (accessor.Has("sparse")) {
+        error = "sparse accessors are not supported";
+        return false;
+    }
+    const std::string& type = accessor["type"].string;
+    result.components = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+    result.componentType = accessor["componentType"].Integer(0);
+    int64_t componentType = result.componentType;
+    result.componentSize = componentType == 5126 || componentType == 5125 ? 4 : componentType == 5122 || componentType == 5123 ? 2
+                         : componentType == 5120 || componentType == 5121 ? 1 : 0;
+    result.count = static_cast<uint64_t>(accessor["count"].Integer(0));
+    if (result.components == 0 || result.componentSize == 0) {
+        error = "unsupported accessor type";
+        return false;
+    }
+    result.normalized = accessor["normalized"].boolean;
+    if (!accessor.Has("bufferView")) {
+        return true;
+    }
+
+    const Json& view = document.json["bufferViews"].At(static_cast<size_t>(accessor["bufferView"].Integer(-1)));
+    int64_t bufferIndex = view["buffer"].Integer(-1);
+    if (bufferIndex < 0 || static_cast<size_t>(bufferIndex) >= document.buffers.size()) {
+        error = "invalid buffer view";
+        return false;
+    }
+    const std::string& buffer = document.buffers[bufferIndex];
+    uint64_t elementSize = result.components * result.componentSize;
+    result.stride = static_cast<uint64_t>(view["byteStride"].Integer(static_cast<int64_t>(elementSize)));
+    uint64_t viewOffset = static_cast<uint64_t>(view["byteOffset"].Integer(0));
+    uint64_t viewLength = static_cast<uint64_t>(view["byteLength"].Integer(0));
+    uint64_t offset = static_cast<uint64_t>(accessor["byteOffset"].Integer(0));
+    if (viewOffset + viewLength > buffer.size() || (result.count > 0 && offset + result.stride * (result.count - 1) + elementSize > viewLength)) {
+        error = "accessor out of range";
+        return false;
+    }
+    result.base = reinterpret_cast<const uint8_t*>(buffer.data()) + viewOffset + offset;
+    return true;
+}
+
+// 把 accessor 读成 float，每个元素 components 个；整数按 normalized 归一化
+bool readAccessor(const GltfDocument& document, int64_t index, std::vector<float>& values, uint32_t& components, std::string& error) {
+    AccessorView view;
+    if (!resolveAccessor(document, index, view, error)) {
+        return false;
+    }
+    components = view.components;
+    values.assign(view.count * components, 0.0f);
+    if (view.base == nullptr) {
+        return true;
+    }
+
+    bool normalized = view.normalized;
+    for (uint64_t i = 0; i < view.count; ++i) {
+        const uint8_t* element = view.base + i * view.stride;
+        for (uint32_t c = 0; c < components; ++c) {
+            const uint8_t* source = element + c * view.componentSize;
+            float value = 0.0f;
+            switch (view.componentType) {
+            case 5126: { float v; std::memcpy(&v, source, 4); value = v; break; }
+            case 5125: { uint32_t v; std::memcpy(&v, source, 4); value = static_cast<float>(v); break; }
+            case 5123: { uint16_t v; std::memcpy(&v, source, 2); value = normalized ? v / 65535.0f : v; break; }
+            case 5122: { int16_t v; std::memcpy(&v, source, 2); value = normalized ? std::max(v / 32767.0f, -1.0f) : v; break; }
+            case 5121: value = normalized ? *source / 255.0f : *source; break;
+            case 5120: { int8_t v = static_cast<int8_t>(*source); value = normalized ? std::max(v / 127.0f, -1.0f) : v; break; }
+            }
+            values[i * components + c] = value;
+        }
+    }
+    return true;
+}
+
+// 索引 accessor 直接读成 uint32：经 float 中转时超过 2^24 的索引会丢精度
+bool readIndexAccessor(const GltfDocument& document, int64_t index, std::vector<uint32_t>& values, std::string& error) {
+    AccessorView view;
+    if (!resolveAccessor(document, index, view, error)) {
+        return false;
+    }
+    if (view.components != 1 || (view.componentType != 5121 && view.componentType != 5123 && view.componentType != 5125)) {
+        error = "indices must be unsigned byte, short or int scalars";
+        return false;
+    }
+    values.assign(view.count, 0);
+    if (view.base == nullptr) {
+        return true;
+    }
+    for (uint64_t i = 0; i < view.count; ++i) {
+        const uint8_t* source = view.base + i * view.stride;
+        switch (view.componentType) {
+        case 5125: std::memcpy(&values[i], source, 4); break;
+        case 5123: { uint16_t v; std::memcpy(&v, source, 2); values[i] = v; break; }
+        case 5121: values[i] = *source; break;
+        }
+    }
+    return true;
+}
+
+struct GltfPrimitiveJob {
+    const Json* primitive;
+    Matrix transform;
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::string error;
+};
+
+void decodePrimitive(const GltfDocument& document, GltfPrimitiveJob& job) {
+    const Json& primitive = *job.primitive;
+    if (primitive["mode"].Integer(4) != 4) {
+        job.error = "only triangle lists are supported";
+        return;
+    }
+    const Json& attributes = primitive["attributes"];
+    std::vector<float> positions;
+    uint32_t positionComponents = 0;
+    if (!attributes.Has("POSITION") || !readAccessor(document, attributes["POSITION"].Integer(-1), positions, positionComponents, job.error)) {
+        job.error = "POSITION: " + (job.error.empty() ? std::string("missing") : job.error);
+        return;
+    }
+    if (positionComponents != 3) {
+        job.error = "POSITION must be VEC3";
+        return;
+    }
+    std::vector<float> colors;
+    uint32_t colorComponents = 0;
+    if (attributes.Has("COLOR_0") && !readAccessor(document, attributes["COLOR_0"].Integer(-1), colors, colorComponents, job.error)) {
+        job.error = "COLOR_0: " + job.error;
+        return;
+    }
+
+    size_t vertexCount = positions.size() / 3;
+    job.vertices.resize(vertexCount, kDefaultVertex);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        job.transform.Transform(&positions[i * 3], job.vertices[i].position);
+        if (colorComponents >= 3 && (i + 1) * colorComponents <= colors.size()) {
+            std::memcpy(job.vertices[i].color, &colors[i * colorComponents], sizeof(job.vertices[i].color));
+        }
+    }
+
+    if (primitive.Has("indices")) {
+        if (!readIndexAccessor(document, primitive["indices"].Integer(-1), job.indices, job.error)) {
+            job.error = "indices: " + job.error;
+            return;
+        }
+        for (uint32_t index : job.indices) {
+            if (index >= vertexCount) {
+                job.error = "index out of range";
+                return;
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            job.indices.push_back(i);
+        }
+    }
+    job.indices.resize(job.indices.size() / 3 * 3);
+}
+
+// 从场景根节点往下走，收集 (mesh, 世界矩阵)；没有场景时每个 mesh 按单位矩阵出现一次
+void collectMeshInstances(const Json& json, std::vector<std::pair<int64_t, Matrix>>& instances) {
+    const Json& scenes = json["scenes"];
+    if (scenes.Size() == 0) {
+        for (size_t i = 0; i < json["meshes"].Size(); ++i) {
+            instances.emplace_back(static_cast<int64_t>(i), Matrix());
+        }
+        return;
+    }
+    const Json& scene = scenes.At(static_cast<size_t>(json["scene"].Integer(0)));
+    const Json& nodes = json["nodes"];
+    std::vector<std::pair<int64_t, Matrix>> stack;
+    for (const Json& root : scene["nodes"].array) {
+        stack.emplace_back(root.Integer(-1), Matrix());
+    }
+    size_t visited = 0;
+    while (!stack.empty() && visited++ <= nodes.Size()) { // 防止成环
+        auto current = stack.back();
+        stack.pop_back();
+        const Json& node = nodes.At(static_cast<size_t>(current.first));
+        Matrix world = current.second * nodeMatrix(node);
+        if (node.Has("mesh")) {
+            instances.emplace_back(node["mesh"].Integer(-1), world);
+        }
+        for (const Json& child : node["children"].array) {
+            stack.emplace_back(child.Integer(-1), world);
+        }
+    }
+}
+
+} // namespace
+
+
+MeshImporter::MeshImporter(uint32_t threadCount)
+    : pool(threadCount) {
+}
+
+bool MeshImporter::Import(const std::string& path, Mesh& mesh) {
+    std::string extension = lowerExtension(path);
+    if (extension == "obj") {
+        return ImportObj(path, mesh);
+    }
+    if (extension == "gltf" || extension == "glb") {
+        return ImportGltf(path, mesh);
+    }
+    std::cout << "MeshImporter: " << path << ": unknown file type" << std::endl;
+    return false;
+}
+
+bool MeshImporter::ImportObj(const std::string& path, Mesh& mesh) {
+    Clock::time_point start = Clock::now();
+    stats = MeshImportStats();
+    std::string text;
+    if (!readFile(path, text)) {
+        std::cout << "MeshImporter: could not open " << path << std::endl;
+        return false;
+    }
+
+    // 切块：每个线程几块，块不小于 64 KB；边界挪到下一个换行之后
+    const size_t minChunkSize = 64 * 1024;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.GetConcurrency() * 4, text.size() / minChunkSize));
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* data = text.data();
+    const char* end = data + text.size();
+    const char* cursor = data;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* chunkEnd = i + 1 == chunkCount ? end : std::max(cursor, data + text.size() * (i + 1) / chunkCount);
+        const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+        chunkEnd = newline != nullptr ? newline + 1 : end;
+        chunks[i].begin = cursor;
+        chunks[i].end = chunkEnd;
+        cursor = chunkEnd;
+    }
+
+    Clock::time_point parseStart = Clock::now();
+    pool.ParallelFor(static_cast<uint32_t>(chunks.size()), [&chunks](uint32_t i) { parseObjChunk(chunks[i]); });
+    stats.parseMillis = millisSince(parseStart);
+    stats.chunks = static_cast<uint32_t>(chunks.size());
+
+    // 拼接：顶点按块顺序连起来，相对索引加上前面各块的顶点数
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (const ObjChunk& chunk : chunks) {
+        if (!chunk.error.empty()) {
+            std::cout << "MeshImporter: " << path << ": " << chunk.error << std::endl;
+            return false;
+        }
+        int64_t prefix = static_cast<int64_t>(vertices.size());
+        vertices.insert(vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+        for (const ObjReference& reference : chunk.triangles) {
+            int64_t index = reference.relative ? prefix + reference.value : reference.value;
+            indices.push_back(static_cast<uint32_t>(index));
+            if (index < 0 || index >= UINT32_MAX) {
+                std::cout << "MeshImporter: " << path << ": face refers to a vertex out of range" << std::endl;
+                return false;
+            }
+        }
+    }
+    // 正索引可能指向后面的块里的顶点，全部拼完再检查
+    for (uint32_t index : indices) {
+        if (index >= vertices.size()) {
+            std::cout << "MeshImporter: " << path << ": face refers to vertex " << index + 1 << " of " << vertices.size() << std::endl;
+            return false;
+        }
+    }
+
+    deduplicate(vertices, indices, mesh);
+    stats.corners = static_cast<uint32_t>(indices.size());
+    stats.uniqueVertices = static_cast<uint32_t>(mesh.vertices.size());
+    stats.totalMillis = millisSince(start);
+    return true;
+}
+
+bool MeshImporter::ImportGltf(const std::string& path, Mesh& mesh) {
+    Clock::time_point start = Clock::now();
+    stats = MeshImportStats();
+    auto fail = [&path](const std::string& message) {
+        std::cout << "MeshImporter: " << path << ": " << message << std::endl;
+        return false;
+    };
+    std::string contents;
+    if (!readFile(path, contents)) {
+        return fail("could not open");
+    }
+
+    // .glb：12 字节文件头，然后是 JSON 块和可选的 BIN 块，各自 8 字节块头
+    GltfDocument document;
+    const char* jsonBegin = contents.data();
+    const char* jsonEnd = contents.data() + contents.size();
+    std::string binaryChunk;
+    bool hasBinaryChunk = false;
+    if (contents.size() >= 12 && std::memcmp(contents.data(), "glTF", 4) == 0) {
+        uint32_t header[3];
+        std::memcpy(header, contents.data(), sizeof(header));
+        if (header[1] != 2 || header[2] > contents.size()) {
+            return fail("unsupported glb header");
+        }
+        jsonBegin = jsonEnd = nullptr;
+        for (size_t offset = 12; offset + 8 <= header[2];) {
+            uint32_t chunkHeader[2];
+            std::memcpy(chunkHeader, contents.data() + offset, sizeof(chunkHeader));
+            size_t chunkStart = offset + 8;
+            if (chunkHeader[0] > header[2] - chunkStart) {
+                return fail("glb chunk out of range");
+            }
+            if (chunkHeader[1] == 0x4E4F534A && jsonBegin == nullptr) {         // "JSON"
+                jsonBegin = contents.data() + chunkStart;
+                jsonEnd = jsonBegin + chunkHeader[0];
+            } else if (chunkHeader[1] == 0x004E4942 && !hasBinaryChunk) {      // "BIN\0"
+                binaryChunk.assign(contents.data() + chunkStart, chunkHeader[0]);
+                hasBinaryChunk = true;
+            }
+            offset = chunkStart + ((chunkHeader[0] + 3) & ~3u);
+        }
+        if (jsonBegin == nullptr) {
+            return fail("glb without a JSON chunk");
+        }
+    }
+    if (!JsonParser(jsonBegin, jsonEnd).Parse(document.json)) {
+        return fail("invalid JSON");
+    }
+    if (document.json["asset"]["version"].string.compare(0, 1, "2") != 0) {
+        return fail("only glTF 2.0 is supported");
+    }
+
+    // buffers：没有 uri 的是 glb 的 BIN 块，data: 是内嵌的 base64，其它是相对路径的外部文件
+    for (const Json& buffer : document.json["buffers"].array) {
+        const std::string& uri = buffer["uri"].string;
+        document.buffers.emplace_back();
+        if (uri.empty()) {
+            if (!hasBinaryChunk) {
+                return fail("buffer without uri outside of a glb");
+            }
+            document.buffers.back() = binaryChunk;
+        } else if (uri.compare(0, 5, "data:") == 0) {
+            size_t comma = uri.find(',');
+            if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos
+                || !decodeBase64(uri, comma + 1, document.buffers.back())) {
+                return fail("invalid data uri");
+            }
+        } else if (!readFile(directoryOf(path) + uri, document.buffers.back())) {
+            return fail("could not open buffer " + uri);
+        }
+        if (document.buffers.back().size() < static_cast<size_t>(buffer["byteLength"].Integer(0))) {
+            return fail("buffer shorter than its byteLength");
+        }
+    }
+
+    std::vector<std::pair<int64_t, Matrix>> instances;
+    collectMeshInstances(document.json, instances);
+    std::vector<GltfPrimitiveJob> jobs;
+    for (const auto& instance : instances) {
+        const Json& meshJson = document.json["meshes"].At(static_cast<size_t>(instance.first));
+        for (const Json& primitive : meshJson["primitives"].array) {
+            jobs.push_back(GltfPrimitiveJob{ &primitive, instance.second, {}, {}, {} });
+        }
+    }
+    if (jobs.empty()) {
+        return fail("no mesh primitives in the scene");
+    }
+
+    Clock::time_point parseStart = Clock::now();
+    pool.ParallelFor(static_cast<uint32_t>(jobs.size()), [&document, &jobs](uint32_t i) { decodePrimitive(document, jobs[i]); });
+    stats.parseMillis = millisSince(parseStart);
+    stats.chunks = static_cast<uint32_t>(jobs.size());
+
+    std::vector<Mesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (const GltfPrimitiveJob& job : jobs) {
+        if (!job.error.empty()) {
+            return fail(job.error);
+        }
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        vertices.insert(vertices.end(), job.vertices.begin(), job.vertices.end());
+        for (uint32_t index : job.indices) {
+            indices.push_back(base + index);
+        }
+    }
+
+    deduplicate(vertices, indices, mesh);
+    stats.corners = static_cast<uint32_t>(indices.size());
+    stats.uniqueVertices = static_cast<uint32_t>(mesh.vertices.size());
+    stats.totalMillis = millisSince(start);
+    return true;
+}
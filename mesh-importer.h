@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.h"
+#include "worker-pool.h"
+
+#include <cstdint>
+#include <string>
+
+// 网格导入：OBJ 与 glTF 2.0（.gltf 的 data URI / 外部 .bin，以及 .glb 的二进制块），输出 Mesh（位置 + 颜色，三角形列表）。
+//   OBJ  ：文件按行切成若干块交给 WorkerPool 并行解析（v / f，多边形按扇形三角化，负索引按块前缀还原），再按序拼接
+//   glTF ：每个 primitive 一个任务并行解码 accessor，烘焙节点的世界变换
+// 渲染用的布局只有位置和颜色，法线/UV 不读；最后用哈希表按 (位置, 颜色) 合并重复顶点，
+// 只因法线/UV 不同而被拆开的顶点也会合并回来。OBJ 的 "v x y z r g b" 扩展带颜色，没有颜色时为白色。
+struct MeshImportStats {
+    uint32_t chunks = 0;            // 并行任务数（OBJ 的块 / glTF 的 primitive）
+    uint32_t corners = 0;           // 合并前的顶点数（三角形数 * 3）
+    uint32_t uniqueVertices = 0;
+    double parseMillis = 0.0;
+    double totalMillis = 0.0;
+};
+
+class MeshImporter {
+public:
+    // threadCount 传给 WorkerPool，0 表示按 CPU 核数
+    explicit MeshImporter(uint32_t threadCount = 0);
+
+    // 按扩展名选格式；失败时打印 文件 与原因并返回 false
+    bool Import(const std::string& path, Mesh& mesh);
+    bool ImportObj(const std::string& path, Mesh& mesh);
+    bool ImportGltf(const std::string& path, Mesh& mesh);
+
+    const MeshImportStats& GetStats() const { return stats; }
+
+private:
+    WorkerPool pool;
+    MeshImportStats stats;
+};
@@ -0,0 +1,244 @@
+#include "mesh-optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 顶点 -> 用到它的三角形，CSR 形式
+struct Adjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    Adjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+        : offsets(vertexCount + 1, 0), triangles(indices.size()) {
+        for (uint32_t index : indices) {
+            ++offsets[index + 1];
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+};
+
+} // namespace
+
+
+float computeAcmr(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+    // FIFO：顶点进缓存时记下时间戳，时间戳落后超过 cacheSize 就已经被挤出去了
+    std::vector<uint64_t> cachedAt(vertexCount, 0);
+    uint64_t timestamp = cacheSize + 1;
+    uint64_t misses = 0;
+    for (uint32_t index : indices) {
+        if (timestamp - cachedAt[index] > cacheSize) {
+            cachedAt[index] = timestamp++;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize,
+                                          std::vector<uint32_t>* clusters) {
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    if (clusters != nullptr) {
+        clusters->clear();
+    }
+    if (triangleCount == 0) {
+        return result;
+    }
+
+    Adjacency adjacency(indices, vertexCount);
+    std::vector<uint32_t> live(vertexCount);   // 还没输出的相邻三角形数
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint64_t> cachedAt(vertexCount, 0);
+    uint64_t timestamp = cacheSize + 1;
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;     // 最近输出过的顶点，走进死胡同时从这里回退
+    std::vector<uint32_t> candidates;
+    uint32_t cursor = 0;                // 回退也找不到时，按顶点编号顺序往后找
+
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v] > 0) {
+                return v;
+            }
+        }
+        for (; cursor < vertexCount; ++cursor) {
+            if (live[cursor] > 0) {
+                return cursor;
+            }
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    bool newCluster = true;
+    while (fanning >= 0) {
+        if (newCluster && clusters != nullptr) {
+            clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+        }
+        // 以 fanning 为中心输出它所有剩下的三角形
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+            uint32_t triangle = adjacency.triangles[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t v = indices[triangle * 3 + corner];
+                result.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (timestamp - cachedAt[v] > cacheSize) {
+                    cachedAt[v] = timestamp++;
+                }
+            }
+        }
+
+        // 下一个中心：输出完它的三角形后仍在缓存里的顶点里，最早进缓存的那个
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            uint64_t age = timestamp - cachedAt[v];
+            if (age + 2 * live[v] <= cacheSize) {
+                priority = static_cast<int64_t>(age);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        newCluster = best < 0;  // 死胡同：这里是簇的边界，之后的三角形与之前的不相连
+        fanning = best >= 0 ? best : skipDeadEnd();
+    }
+    return result;
+}
+
+bool optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Mesh::Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold) {
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (clusters.size() < 2 || vertices.empty()) {
+        return false;
+    }
+
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    for (const Mesh::Vertex& vertex : vertices) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            meshCenter[axis] += vertex.position[axis] / vertices.size();
+        }
+    }
+
+    // 每个簇：面积加权的中心与法线，朝外程度 = dot(中心 - 网格中心, 法线)
+    struct Cluster {
+        uint32_t begin;
+        uint32_t end;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster cluster{ clusters[c], c + 1 < clusters.size() ? clusters[c + 1] : triangleCount, 0.0f };
+        float center[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float totalArea = 0.0f;
+        for (uint32_t t = cluster.begin; t < cluster.end; ++t) {
+            const float* p0 = vertices[indices[t * 3 + 0]].position;
+            const float* p1 = vertices[indices[t * 3 + 1]].position;
+            const float* p2 = vertices[indices[t * 3 + 2]].position;
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                center[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+                normal[axis] += cross[axis];
+            }
+            totalArea += area;
+        }
+        if (totalArea > 0.0f) {
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                float toCenter = center[axis] / totalArea - meshCenter[axis];
+                cluster.sortKey += length > 0.0f ? toCenter * normal[axis] / length : 0.0f;
+            }
+        }
+        sorted.push_back(cluster);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(indices.size());
+    for (const Cluster& cluster : sorted) {
+        reordered.insert(reordered.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    // 簇之间的衔接处缓存命中会变差，差太多就不值得
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (computeAcmr(reordered, vertexCount, cacheSize) > computeAcmr(indices, vertexCount, cacheSize) * threshold) {
+        return false;
+    }
+    indices.swap(reordered);
+    return true;
+}
+
+uint32_t optimizeVertexFetch(Mesh& mesh) {
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+    std::vector<Mesh::Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    auto remapIndices = [&](std::vector<uint32_t>& indices) {
+        for (uint32_t& index : indices) {
+            if (remap[index] == unused) {
+                remap[index] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+    };
+    // LOD 用的顶点是 LOD 0 的子集，按 LOD 0 的顺序排
+    remapIndices(mesh.indices);
+    for (Mesh::Lod& lod : mesh.lods) {
+        remapIndices(lod.indices);
+    }
+    uint32_t removed = static_cast<uint32_t>(mesh.vertices.size() - vertices.size());
+    mesh.vertices.swap(vertices);
+    return removed;
+}
+
+MeshOptimizationStats optimizeMesh(Mesh& mesh, uint32_t cacheSize, float overdrawThreshold) {
+    MeshOptimizationStats stats;
+    uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    stats.acmrBefore = computeAcmr(mesh.indices, vertexCount, cacheSize);
+
+    std::vector<uint32_t> clusters;
+    mesh.indices = optimizeVertexCache(mesh.indices, vertexCount, cacheSize, &clusters);
+    stats.clusterCount = static_cast<uint32_t>(clusters.size());
+    stats.overdrawSorted = optimizeOverdraw(mesh.indices, mesh.vertices, clusters, cacheSize, overdrawThreshold);
+    // 粗的 LOD 三角形少、远处才用，overdraw 影响小，只做顶点缓存
+    for (Mesh::Lod& lod : mesh.lods) {
+        lod.indices = optimizeVertexCache(lod.indices, vertexCount, cacheSize);
+    }
+    // 只改顶点编号，不改三角形顺序，ACMR 不变
+    stats.removedVertices = optimizeVertexFetch(mesh);
+    stats.acmrAfter = computeAcmr(mesh.indices, static_cast<uint32_t>(mesh.vertices.size()), cacheSize);
+    return stats;
+}
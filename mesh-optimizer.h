@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// 网格预处理，加载时跑一遍，纯 CPU：
+//   1. 顶点缓存优化（Tipsify）：重排三角形，让相邻三角形尽量复用刚变换过的顶点，降低 ACMR
+//   2. overdraw 优化：把 1 的结果按簇排序，朝外的簇先画，前面的像素能挡住后面的；ACMR 变差太多就放弃
+//   3. 顶点读取优化：顶点按索引里第一次出现的顺序重排，读取更连续，同时丢掉没用到的顶点
+// ACMR（average cache miss ratio）= 模拟 FIFO 顶点缓存时的未命中次数 / 三角形数，1 附近已经很好，最坏是 3。
+
+struct MeshOptimizationStats {
+    float acmrBefore = 0.0f;
+    float acmrAfter = 0.0f;
+    uint32_t clusterCount = 0;      // Tipsify 产生的簇数（overdraw 排序的单位）
+    bool overdrawSorted = false;    // false：排序后 ACMR 超过阈值，保留了 Tipsify 的顺序
+    uint32_t removedVertices = 0;   // 没被任何三角形引用、被丢掉的顶点
+};
+
+// 模拟大小为 cacheSize 的 FIFO 顶点缓存
+float computeAcmr(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+
+// Tipsify（Sander et al. 2007）。clusters 非空时写入每个簇起始三角形的下标（首元素为 0）
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize,
+                                          std::vector<uint32_t>* clusters = nullptr);
+
+// 按簇的朝外程度排序：dot(簇中心 - 网格中心, 簇法线) 大的先画。ACMR 超过 acmrBefore * threshold 时返回 false、不修改 indices
+bool optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Mesh::Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold);
+
+// 顶点按第一次被引用的顺序重排并改写索引（mesh.lods 一起改写），返回丢掉的顶点数
+uint32_t optimizeVertexFetch(Mesh& mesh);
+
+// 依次做上面三步
+MeshOptimizationStats optimizeMesh(Mesh& mesh, uint32_t cacheSize = 16, float overdrawThreshold = 1.05f);
@@ -0,0 +1,301 @@
+#include "mesh-simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+// 对称 4x4 矩阵的 10 个系数；weight 为累计的面积权重，Evaluate 除以它得到平均的距离平方
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double weight = 0;
+
+    void AddPlane(double a, double b, double c, double d, double w) {
+        a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+        b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+        c2 += w * c * c; cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    Quadric operator+(const Quadric& q) const {
+        Quadric r;
+        r.a2 = a2 + q.a2; r.ab = ab + q.ab; r.ac = ac + q.ac; r.ad = ad + q.ad;
+        r.b2 = b2 + q.b2; r.bc = bc + q.bc; r.bd = bd + q.bd;
+        r.c2 = c2 + q.c2; r.cd = cd + q.cd;
+        r.d2 = d2 + q.d2;
+        r.weight = weight + q.weight;
+        return r;
+    }
+
+    double Evaluate(const float p[3]) const {
+        double x = p[0], y = p[1], z = p[2];
+        double value = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                     + 2 * (ad * x + bd * y + cd * z) + d2;
+        return weight > 0 ? std::max(value, 0.0) / weight : 0.0;
+    }
+};
+
+struct Vec3 {
+    double x, y, z;
+};
+
+Vec3 toVec(const float p[3]) { return { p[0], p[1], p[2] }; }
+Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vec3 cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+double length(const Vec3& a) { return std::sqrt(dot(a, a)); }
+
+// 边界平面的权重相对三角形平面放大，边界的形状优先保留
+const double kBorderWeight = 10.0;
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+struct PositionHash {
+    size_t operator()(const Mesh::Vertex* vertex) const {
+        uint32_t bits[3];
+        std::memcpy(bits, vertex->position, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+struct PositionEqual {
+    bool operator()(const Mesh::Vertex* a, const Mesh::Vertex* b) const {
+        return std::memcmp(a->position, b->position, sizeof(a->position)) == 0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;    // 距离平方
+};
+
+} // namespace
+
+
+std::vector<uint32_t> simplifyMesh(const Mesh& mesh, const std::vector<uint32_t>& indices, uint32_t targetIndexCount,
+                                   float maxError, float* error) {
+    std::vector<uint32_t> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    double appliedCost = 0.0;
+    if (error != nullptr) {
+        *error = 0.0f;
+    }
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    if (result.size() <= targetIndexCount || vertexCount == 0) {
+        return result;
+    }
+    auto position = [&mesh](uint32_t v) { return mesh.vertices[v].position; };
+
+    // 接缝：位置相同的顶点全部锁定
+    std::vector<bool> locked(vertexCount, false);
+    std::unordered_map<const Mesh::Vertex*, uint32_t, PositionHash, PositionEqual> positions;
+    positions.reserve(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        auto inserted = positions.emplace(&mesh.vertices[v], v);
+        if (!inserted.second) {
+            locked[v] = true;
+            locked[inserted.first->second] = true;
+        }
+    }
+
+    // 边 -> 用到它的三角形数，1 为开放边界
+    std::unordered_map<uint64_t, uint32_t> edgeUse;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        for (uint32_t e = 0; e < 3; ++e) {
+            ++edgeUse[edgeKey(result[i + e], result[i + (e + 1) % 3])];
+        }
+    }
+    auto isBorderEdge = [&edgeUse](uint32_t a, uint32_t b) {
+        auto it = edgeUse.find(edgeKey(a, b));
+        return it != edgeUse.end() && it->second == 1;
+    };
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<bool> border(vertexCount, false);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        Vec3 p[3] = { toVec(position(result[i])), toVec(position(result[i + 1])), toVec(position(result[i + 2])) };
+        Vec3 normal = cross(p[1] - p[0], p[2] - p[0]);
+        double area = length(normal);
+        if (area <= 0.0) {
+            continue;
+        }
+        normal = { normal.x / area, normal.y / area, normal.z / area };
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            quadrics[result[i + corner]].AddPlane(normal.x, normal.y, normal.z, -dot(normal, p[0]), 0.5 * area);
+        }
+        for (uint32_t e = 0; e < 3; ++e) {
+            uint32_t a = result[i + e];
+            uint32_t b = result[i + (e + 1) % 3];
+            if (!isBorderEdge(a, b)) {
+                continue;
+            }
+            Vec3 direction = p[(e + 1) % 3] - p[e];
+            Vec3 side = cross(direction, normal);
+            double sideLength = length(side);
+            if (sideLength <= 0.0) {
+                continue;
+            }
+            side = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+            double weight = kBorderWeight * dot(direction, direction);
+            quadrics[a].AddPlane(side.x, side.y, side.z, -dot(side, p[e]), weight);
+            quadrics[b].AddPlane(side.x, side.y, side.z, -dot(side, p[e]), weight);
+            border[a] = border[b] = true;
+        }
+    }
+
+    const double maxCost = static_cast<double>(maxError) * maxError;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    // 一轮：收集所有可行的折叠按误差排序，互不相邻的一批同时做，然后重建索引
+    while (result.size() > targetIndexCount) {
+        offsets.assign(vertexCount + 1, 0);
+        for (uint32_t v : result) {
+            ++offsets[v + 1];
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+            adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        auto canCollapse = [&](uint32_t from, uint32_t to) {
+            // 边界顶点只能沿边界边移动；内部顶点可以并到边界上
+            return !locked[from] && (!border[from] || isBorderEdge(from, to));
+        };
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (uint32_t e = 0; e < 3; ++e) {
+                uint32_t a = result[i + e];
+                uint32_t b = result[i + (e + 1) % 3];
+                if (a > b && !isBorderEdge(a, b)) {
+                    continue; // 内部边在两个三角形里各出现一次，只取一次
+                }
+                Quadric merged = quadrics[a] + quadrics[b];
+                double costAB = canCollapse(a, b) ? merged.Evaluate(position(b)) : -1.0;
+                double costBA = canCollapse(b, a) ? merged.Evaluate(position(a)) : -1.0;
+                if (costAB >= 0.0 && (costBA < 0.0 || costAB <= costBA)) {
+                    collapses.push_back({ a, b, costAB });
+                } else if (costBA >= 0.0) {
+                    collapses.push_back({ b, a, costBA });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), false);
+        size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.cost > maxCost || removed >= trianglesToRemove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+            // 移动后 from 周围剩下的三角形不能翻面
+            bool flips = false;
+            uint32_t degenerate = 0;
+            for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1] && !flips; ++k) {
+                const uint32_t* triangle = &result[adjacency[k] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                    ++degenerate;
+                    continue;
+                }
+                Vec3 before[3];
+                Vec3 after[3];
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    before[corner] = toVec(position(triangle[corner]));
+                    after[corner] = triangle[corner] == collapse.from ? toVec(position(collapse.to)) : before[corner];
+                }
+                Vec3 normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+                Vec3 normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+                flips = dot(normalBefore, normalAfter) <= 0.0;
+            }
+            if (flips) {
+                continue;
+            }
+            // 两端点周围的顶点本轮都不再动，保证上面的翻面检查仍然成立
+            for (uint32_t end : { collapse.from, collapse.to }) {
+                for (uint32_t k = offsets[end]; k < offsets[end + 1]; ++k) {
+                    const uint32_t* triangle = &result[adjacency[k] * 3];
+                    touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+                }
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] = quadrics[collapse.to] + quadrics[collapse.from];
+            appliedCost = std::max(appliedCost, collapse.cost);
+            removed += degenerate;
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = remap[result[i]];
+            uint32_t b = remap[result[i + 1]];
+            uint32_t c = remap[result[i + 2]];
+            if (a != b && b != c && a != c) {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+        // 折叠后新出现的边界（很少见）按新的三角形重算
+        edgeUse.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (uint32_t e = 0; e < 3; ++e) {
+                ++edgeUse[edgeKey(result[i + e], result[i + (e + 1) % 3])];
+            }
+        }
+    }
+    if (error != nullptr) {
+        *error = static_cast<float>(std::sqrt(appliedCost));
+    }
+    return result;
+}
+
+void buildLodChain(Mesh& mesh, uint32_t maxLevels, float maxError) {
+    mesh.lods.clear();
+    float accumulated = 0.0f;
+    for (uint32_t level = 1; level < maxLevels; ++level) {
+        const std::vector<uint32_t>& previous = mesh.lods.empty() ? mesh.indices : mesh.lods.back().indices;
+        uint32_t target = static_cast<uint32_t>(previous.size() / 6 * 3);
+        float levelError = 0.0f;
+        // 从上一级继续简化：更快，且各级之间是嵌套的；误差按级累加
+        std::vector<uint32_t> simplified = simplifyMesh(mesh, previous, target, maxError - accumulated, &levelError);
+        if (simplified.empty() || simplified.size() * 10 > previous.size() * 9) {
+            break;
+        }
+        accumulated += levelError;
+        Mesh::Lod lod;
+        lod.indices = std::move(simplified);
+        lod.error = accumulated;
+        mesh.lods.push_back(std::move(lod));
+    }
+}
+
+uint32_t selectLod(const std::vector<LodLevel>& levels, float pixelsPerUnit, float maxPixelError) {
+    for (uint32_t level = static_cast<uint32_t>(levels.size()); level-- > 1;) {
+        if (levels[level].error * pixelsPerUnit <= maxPixelError) {
+            return level;
+        }
+    }
+    return 0;
+}
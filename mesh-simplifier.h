@@ -0,0 +1,29 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// 二次误差度量（QEM, Garland & Heckbert 1997）的边折叠简化。
+// 顶点只折叠到已有的另一个顶点上，不产生新顶点：各级 LOD 共用同一份顶点 buffer，只是索引不同。
+// 每个顶点累计相邻三角形平面的二次型；开放边界额外加一个垂直于边界的平面，边界只能沿着自己收缩。
+// 同一位置上有多个顶点（颜色等属性不同的接缝）时这些顶点不动，免得把接缝撕开。
+
+// 简化到不多于 targetIndexCount 个索引，或者下一次折叠的误差超过 maxError（网格坐标单位）为止。
+// error 非空时写入实际用到的最大误差
+std::vector<uint32_t> simplifyMesh(const Mesh& mesh, const std::vector<uint32_t>& indices, uint32_t targetIndexCount,
+                                   float maxError, float* error = nullptr);
+
+// 从 mesh.indices 开始逐级减半生成 mesh.lods，最多 maxLevels - 1 级；某一级减少不到 10% 就停
+void buildLodChain(Mesh& mesh, uint32_t maxLevels, float maxError);
+
+// 运行时的一级 LOD：在合并后的 index buffer 里的 draws 范围 + 几何误差
+struct LodLevel {
+    uint32_t firstDraw = 0;
+    uint32_t drawCount = 0;
+    float error = 0.0f;             // 网格坐标单位；LOD 0 为 0
+};
+
+// 投影后误差（error * pixelsPerUnit）不超过 maxPixelError 的最粗一级
+uint32_t selectLod(const std::vector<LodLevel>& levels, float pixelsPerUnit, float maxPixelError);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// CPU 端的网格：上传之前的各个处理步骤（压缩、优化、切分 ...）都基于它
+struct Mesh {
+    struct Vertex {
+        float position[3];
+        float color[3];
+    };
+    // 更粗的细节层次，与 indices 共用 vertices；error 为相对原网格的几何误差（坐标单位），逐级增大
+    struct Lod {
+        std::vector<uint32_t> indices;
+        float error = 0.0f;
+    };
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;  // 三角形列表（LOD 0）
+    std::vector<Lod> lods;          // LOD 1, 2, ...（buildLodChain 生成，可以为空）
+};
@@ -0,0 +1,132 @@
+#include "meshlet-builder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const uint32_t kNotInMeshlet = ~0u;
+
+// 包围球取块内顶点包围盒的中心；法线锥取三角形单位法线的平均方向，半角由最偏的那个法线决定
+void computeBounds(const Mesh& mesh, const MeshletData& data, Meshlet& meshlet) {
+    float lower[3];
+    float upper[3];
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        lower[axis] = upper[axis] = mesh.vertices[data.vertices[meshlet.vertexOffset]].position[axis];
+    }
+    for (uint32_t v = 0; v < meshlet.vertexCount; ++v) {
+        const float* position = mesh.vertices[data.vertices[meshlet.vertexOffset + v]].position;
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            lower[axis] = std::min(lower[axis], position[axis]);
+            upper[axis] = std::max(upper[axis], position[axis]);
+        }
+    }
+    float radius = 0.0f;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        meshlet.center[axis] = 0.5f * (lower[axis] + upper[axis]);
+    }
+    for (uint32_t v = 0; v < meshlet.vertexCount; ++v) {
+        const float* position = mesh.vertices[data.vertices[meshlet.vertexOffset + v]].position;
+        float dx = position[0] - meshlet.center[0];
+        float dy = position[1] - meshlet.center[1];
+        float dz = position[2] - meshlet.center[2];
+        radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+    }
+    meshlet.radius = std::sqrt(radius);
+
+    std::vector<float> normals;
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        uint32_t packed = data.triangles[meshlet.triangleOffset + t];
+        const float* p[3];
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            p[corner] = mesh.vertices[data.vertices[meshlet.vertexOffset + ((packed >> (8 * corner)) & 0xFF)]].position;
+        }
+        float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+        float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0f) {
+            continue; // 退化三角形不光栅化，不参与法线锥
+        }
+        for (uint32_t i = 0; i < 3; ++i) {
+            normals.push_back(n[i] / length);
+            axis[i] += n[i] / length;
+        }
+    }
+    float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    meshlet.coneCutoff = 1.0f;
+    for (uint32_t i = 0; i < 3; ++i) {
+        meshlet.coneAxis[i] = axisLength > 0.0f ? axis[i] / axisLength : 0.0f;
+    }
+    if (axisLength <= 0.0f) {
+        return;
+    }
+    float minDot = 1.0f;
+    for (size_t i = 0; i < normals.size(); i += 3) {
+        minDot = std::min(minDot, normals[i] * meshlet.coneAxis[0] + normals[i + 1] * meshlet.coneAxis[1] + normals[i + 2] * meshlet.coneAxis[2]);
+    }
+    // 锥的半角超过 90° 时总有三角形朝向视点，不剔除
+    if (minDot > 0.0f) {
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+} // namespace
+
+
+MeshletData buildMeshlets(const Mesh& mesh, const std::vector<const std::vector<uint32_t>*>& levels) {
+    MeshletData data;
+    // 顶点在当前块里的局部编号，块结束时只清掉用到的那些
+    std::vector<uint32_t> localIndex(mesh.vertices.size(), kNotInMeshlet);
+    Meshlet current{};
+
+    auto finish = [&]() {
+        if (current.triangleCount == 0) {
+            return;
+        }
+        computeBounds(mesh, data, current);
+        for (uint32_t v = 0; v < current.vertexCount; ++v) {
+            localIndex[data.vertices[current.vertexOffset + v]] = kNotInMeshlet;
+        }
+        data.meshlets.push_back(current);
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        current.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+    };
+
+    for (const std::vector<uint32_t>* level : levels) {
+        data.levelFirstMeshlet.push_back(static_cast<uint32_t>(data.meshlets.size()));
+        data.maxLevelTriangles = std::max(data.maxLevelTriangles, static_cast<uint32_t>(level->size() / 3));
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        current.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+
+        for (size_t i = 0; i + 2 < level->size(); i += 3) {
+            const uint32_t* triangle = level->data() + i;
+            uint32_t newVertices = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                bool repeated = corner > 0 && triangle[corner] == triangle[0];
+                repeated = repeated || (corner > 1 && triangle[corner] == triangle[1]);
+                newVertices += localIndex[triangle[corner]] == kNotInMeshlet && !repeated ? 1 : 0;
+            }
+            if (current.vertexCount + newVertices > kMeshletMaxVertices || current.triangleCount == kMeshletMaxTriangles) {
+                finish();
+            }
+            uint32_t packed = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t& local = localIndex[triangle[corner]];
+                if (local == kNotInMeshlet) {
+                    local = current.vertexCount++;
+                    data.vertices.push_back(triangle[corner]);
+                }
+                packed |= local << (8 * corner);
+            }
+            data.triangles.push_back(packed);
+            ++current.triangleCount;
+        }
+        finish();
+    }
+    data.levelFirstMeshlet.push_back(static_cast<uint32_t>(data.meshlets.size()));
+    return data;
+}
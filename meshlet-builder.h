@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// 网格簇（meshlet）：三角形列表按顺序贪心地切成小块，每块不超过 kMeshletMaxVertices 个顶点、kMeshletMaxTriangles 个三角形。
+// 块内三角形用块内的局部顶点编号（8 位）存，经 vertices 表换回网格的顶点编号，比直接存 32 位索引小得多。
+// 每块带包围球和法线锥，GPU 上逐块做视口剔除与背面剔除（MeshletCuller）。
+// 输入最好先经 optimizeVertexCache：相邻三角形共享顶点多，块就更满、更紧凑。
+constexpr uint32_t kMeshletMaxVertices = 64;
+constexpr uint32_t kMeshletMaxTriangles = 124;
+
+// 与剔除 shader 里的 struct Meshlet 逐字节一致（vec3f 按 16 字节对齐，后面紧跟一个 f32）
+struct Meshlet {
+    float center[3];            // 包围球，网格坐标
+    float radius;
+    float coneAxis[3];          // 块内三角形法线的平均方向
+    float coneCutoff;           // 视线方向 d 满足 dot(d, coneAxis) > coneCutoff 时整块背对视点；1 表示从不剔除
+    uint32_t vertexOffset;      // MeshletData::vertices 里的起点
+    uint32_t triangleOffset;    // MeshletData::triangles 里的起点
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlet must match the culling shader layout");
+
+struct MeshletData {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;         // 局部顶点 -> 网格顶点编号
+    std::vector<uint32_t> triangles;        // 每个三角形一个 u32，三个局部编号依次占低 24 位的 8 位
+    std::vector<uint32_t> levelFirstMeshlet;    // 第 l 级 LOD 的块为 [levelFirstMeshlet[l], levelFirstMeshlet[l + 1])
+    uint32_t maxLevelTriangles = 0;         // 三角形最多的一级的三角形数，剔除输出的 index buffer 按它分配
+};
+
+// levels 为各级 LOD 的三角形列表（引用 mesh.vertices），每级单独切块
+MeshletData buildMeshlets(const Mesh& mesh, const std::vector<const std::vector<uint32_t>*>& levels);
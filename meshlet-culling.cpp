@@ -0,0 +1,236 @@
+#include "meshlet-culling.h"
+#include "meshlet-builder.h"
+#include "upload-belt.h"
+#include "shader-reflection.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const uint32_t kInstanceStride = 6 * sizeof(uint32_t); // 与 shader 中的 instanceWords 一致
+// 每维最多 65535 个 workgroup（WebGPU 的默认上限），块更多时铺到 y 方向
+const uint32_t kMaxWorkgroupsX = 65535;
+
+// 所有 workgroupBarrier 都在顶层（统一控制流），越界 / 被剔除的 workgroup 只是不做事，不提前返回
+const char* meshletCullShaderSource = R"(
+struct Meshlet {
+    center : vec3f,
+    radius : f32,
+    coneAxis : vec3f,
+    coneCutoff : f32,
+    vertexOffset : u32,
+    triangleOffset : u32,
+    vertexCount : u32,
+    triangleCount : u32,
+};
+
+struct CullState {
+    indexCount : atomic<u32>,
+    instanceCount : u32,
+    firstIndex : u32,
+    baseVertex : i32,
+    firstInstance : u32,
+    firstMeshlet : u32,
+    meshletCount : u32,
+};
+
+struct ViewUniforms {
+    time : f32,
+    aspect : f32,
+};
+
+@group(0) @binding(0) var<uniform> uView : ViewUniforms;
+@group(0) @binding(1) var<storage, read> meshlets : array<Meshlet>;
+@group(0) @binding(2) var<storage, read> meshletVertices : array<u32>;
+@group(0) @binding(3) var<storage, read> meshletTriangles : array<u32>;
+@group(0) @binding(4) var<storage, read> instances : array<u32>;
+@group(0) @binding(5) var<storage, read_write> indices : array<u32>;
+@group(0) @binding(6) var<storage, read_write> state : CullState;
+
+const instanceWords = 6u;           // InstanceData : offset.xy, scale, phase, depth, color
+const workgroupSize = 64u;
+const maxWorkgroupsX = 65535u;
+override orbitRadius : f32 = 0.3;
+override animate : bool = true;
+
+var<workgroup> visibleFlag : atomic<u32>;
+var<workgroup> firstOutput : u32;
+
+// 包围球经实例 i 变换后是否与视口相交
+fn instanceSees(i : u32, center : vec3f, radius : f32) -> bool {
+    let base = i * instanceWords;
+    let offset = vec2f(bitcast<f32>(instances[base]), bitcast<f32>(instances[base + 1u]));
+    let scale = bitcast<f32>(instances[base + 2u]);
+    let phase = bitcast<f32>(instances[base + 3u]);
+    let angle = select(0.0, uView.time, animate) + phase;
+    let centre = offset + orbitRadius * scale * vec2f(cos(angle), sin(angle)) + center.xy * scale;
+    let r = radius * scale;
+    return abs(centre.x) - r <= 1.0 && (abs(centre.y) - r) * uView.aspect <= 1.0;
+}
+
+@compute @workgroup_size(64)
+fn cs_main(@builtin(workgroup_id) group : vec3u, @builtin(local_invocation_index) lane : u32) {
+    if (lane == 0u) {
+        atomicStore(&visibleFlag, 0u);
+    }
+    workgroupBarrier();
+
+    let meshletIndex = group.y * maxWorkgroupsX + group.x;
+    var meshlet : Meshlet;
+    if (meshletIndex < state.meshletCount) {
+        meshlet = meshlets[state.firstMeshlet + meshletIndex];
+        // 视线沿 -z：dot((0, 0, -1), coneAxis) > coneCutoff 时块内所有三角形都背对视点
+        if (-meshlet.coneAxis.z <= meshlet.coneCutoff) {
+            let instanceCount = arrayLength(&instances) / instanceWords;
+            for (var i = lane; i < instanceCount && atomicLoad(&visibleFlag) == 0u; i += workgroupSize) {
+                if (instanceSees(i, meshlet.center, meshlet.radius)) {
+                    atomicStore(&visibleFlag, 1u);
+                }
+            }
+        }
+    }
+    workgroupBarrier();
+
+    let visible = atomicLoad(&visibleFlag) != 0u;
+    if (lane == 0u && visible) {
+        firstOutput = atomicAdd(&state.indexCount, meshlet.triangleCount * 3u);
+    }
+    workgroupBarrier();
+    if (!visible) {
+        return;
+    }
+    let outputBase = firstOutput;
+    for (var t = lane; t < meshlet.triangleCount; t += workgroupSize) {
+        let packed = meshletTriangles[meshlet.triangleOffset + t];
+        for (var corner = 0u; corner < 3u; corner++) {
+            let localVertex = (packed >> (8u * corner)) & 0xffu;
+            indices[outputBase + t * 3u + corner] = meshletVertices[meshlet.vertexOffset + localVertex];
+        }
+    }
+}
+)";
+
+} // namespace
+
+
+MeshletCuller::MeshletCuller(wgpu::Device device)
+    : device(device) {
+}
+
+MeshletCuller::~MeshletCuller() {
+    if (bindGroup != nullptr) {
+        bindGroup.release();
+    }
+    if (pipeline != nullptr) {
+        pipeline.release();
+    }
+    if (layoutPipeline != nullptr) {
+        layoutPipeline.release();
+    }
+    if (layoutBindGroup != nullptr) {
+        layoutBindGroup.release();
+    }
+}
+
+bool MeshletCuller::Initialize(const BufferAllocation& meshlets, const BufferAllocation& meshletVertices, const BufferAllocation& meshletTriangles,
+                               const BufferAllocation& instances, const BufferAllocation& indices, const BufferAllocation& state,
+                               const BufferAllocation& uniform, uint32_t instanceCount, uint32_t instanceStride,
+                               const std::vector<wgpu::ConstantEntry>& constants) {
+    if (instanceStride != kInstanceStride) {
+        std::cout << "MeshletCuller: unexpected instance stride " << instanceStride << std::endl;
+        return false;
+    }
+    this->state = state;
+    this->instanceCount = instanceCount;
+
+    // 0: 帧 uniform（动态偏移），1~3: meshlet 数据，4: 全部实例，5: 输出索引，6: 间接绘制参数 + 本帧的块范围
+    ShaderReflection reflection;
+    if (!reflection.Parse(meshletCullShaderSource)) {
+        return false;
+    }
+    std::vector<wgpu::BindGroupLayoutEntry> layoutEntries = reflection.GetBindGroupLayoutEntries(0);
+    if (layoutEntries.size() != 7 || layoutEntries[1].buffer.minBindingSize != sizeof(Meshlet)
+        || layoutEntries[6].buffer.minBindingSize != kStateSize) {
+        std::cout << "MeshletCuller: unexpected bindings in the culling shader" << std::endl;
+        return false;
+    }
+    layoutEntries[0].buffer.hasDynamicOffset = true;
+
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = meshletCullShaderSource;
+    wgpu::ShaderModuleDescriptor shaderDesc;
+#ifdef WEBGPU_BACKEND_WGPU
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+#endif
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    wgpu::ShaderModule shaderModule = device.createShaderModule(shaderDesc);
+
+    wgpu::BindGroupLayoutDescriptor descGroupLayout{};
+    descGroupLayout.entryCount = layoutEntries.size();
+    descGroupLayout.entries = layoutEntries.data();
+    layoutBindGroup = device.createBindGroupLayout(descGroupLayout);
+
+    wgpu::PipelineLayoutDescriptor descPipelineLayout{};
+    descPipelineLayout.bindGroupLayoutCount = 1;
+    descPipelineLayout.bindGroupLayouts = (WGPUBindGroupLayout*)&layoutBindGroup;
+    layoutPipeline = device.createPipelineLayout(descPipelineLayout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc;
+    pipelineDesc.label = "Meshlet culling";
+    pipelineDesc.layout = layoutPipeline;
+    pipelineDesc.compute.module = shaderModule;
+    pipelineDesc.compute.entryPoint = "cs_main";
+    pipelineDesc.compute.constantCount = constants.size();
+    pipelineDesc.compute.constants = constants.data();
+    pipeline = device.createComputePipeline(pipelineDesc);
+    shaderModule.release();
+
+    const BufferAllocation* buffers[] = { &uniform, &meshlets, &meshletVertices, &meshletTriangles, &instances, &indices, &state };
+    std::vector<wgpu::BindGroupEntry> entries(7, wgpu::Default);
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        entries[i].binding = i;
+        entries[i].buffer = buffers[i]->buffer;
+        entries[i].offset = buffers[i]->offset;
+        entries[i].size = buffers[i]->size;
+    }
+    entries[0].size = 4 * sizeof(float);
+    entries[4].size = static_cast<uint64_t>(instanceCount) * instanceStride;
+    entries[6].size = kStateSize;
+
+    wgpu::BindGroupDescriptor descBindGroup{};
+    descBindGroup.layout = layoutBindGroup;
+    descBindGroup.entryCount = entries.size();
+    descBindGroup.entries = entries.data();
+    bindGroup = device.createBindGroup(descBindGroup);
+    return pipeline != nullptr && bindGroup != nullptr;
+}
+
+void MeshletCuller::Record(wgpu::CommandEncoder encoder, UploadBelt& belt, uint32_t firstMeshlet, uint32_t meshletCount, uint32_t uniformOffset) {
+    // 输出的索引数每帧从 0 开始累计；所有实例共用剔除结果
+    uint32_t* values = (uint32_t*)belt.Write(encoder, state.buffer, state.offset, kStateSize);
+    values[0] = 0;
+    values[1] = instanceCount;
+    values[2] = 0;
+    values[3] = 0;
+    values[4] = 0;
+    values[5] = firstMeshlet;
+    values[6] = meshletCount;
+    if (meshletCount == 0) {
+        return;
+    }
+
+    wgpu::ComputePassDescriptor passDesc;
+    passDesc.label = "Meshlet culling pass";
+    passDesc.timestampWrites = nullptr;
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass(passDesc);
+    computePass.setPipeline(pipeline);
+    computePass.setBindGroup(0, bindGroup, 1, &uniformOffset);
+    computePass.dispatchWorkgroups(std::min(meshletCount, kMaxWorkgroupsX), (meshletCount + kMaxWorkgroupsX - 1) / kMaxWorkgroupsX, 1);
+    computePass.end();
+    computePass.release();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "buffer-allocator.h"
+
+#include <vector>
+
+class UploadBelt;
+
+// GPU 端的网格簇剔除：compute pass 每个 workgroup 处理一个 meshlet（buildMeshlets 的输出），
+//   背面剔除 ：渲染是沿 -z 的正交投影，法线锥整个背对视点的块直接丢掉（pipeline 同时开 cullMode = Back）
+//   视口剔除 ：块的包围球随实例变换（与 vs_main 相同的平移、缩放、绕圈动画）后与视口比较，只要有一个实例看得见就保留
+// 保留下来的块用原子加在输出 index buffer 里占一段，把局部三角形展开成 32 位网格顶点编号写进去，
+// 同时累计 DrawIndexedIndirect 参数的 indexCount；render pass 用一次 drawIndexedIndirect 画出所有实例。
+// 块之间的输出顺序不固定；实例很多时视口测试是对所有实例的并集，只在少数实例的大网格上剔得动。
+class MeshletCuller {
+public:
+    // DrawIndexedIndirect 参数（indexCount, instanceCount, firstIndex, baseVertex, firstInstance）后接 firstMeshlet, meshletCount
+    static constexpr uint64_t kStateSize = 7 * sizeof(uint32_t);
+
+    explicit MeshletCuller(wgpu::Device device);
+    ~MeshletCuller();
+
+    MeshletCuller(const MeshletCuller&) = delete;
+    MeshletCuller& operator=(const MeshletCuller&) = delete;
+
+    // meshlets / meshletVertices / meshletTriangles : MeshletData 的三个数组（只读 storage）
+    // instances : 全部实例（只读 storage），每个实例 instanceStride 字节（须为 Application::InstanceData 的 24 字节布局）
+    // indices   : 输出的 Uint32 索引（storage + index），至少能放下三角形最多的那一级
+    // state     : kStateSize 字节（storage + indirect），前 20 字节就是间接绘制参数
+    // uniform   : 帧 uniform，绑定时用动态偏移选中本帧那一份：time, aspect
+    // constants : 与 vs_main 相同的特化常量（orbitRadius, animate）
+    bool Initialize(const BufferAllocation& meshlets, const BufferAllocation& meshletVertices, const BufferAllocation& meshletTriangles,
+                    const BufferAllocation& instances, const BufferAllocation& indices, const BufferAllocation& state,
+                    const BufferAllocation& uniform, uint32_t instanceCount, uint32_t instanceStride,
+                    const std::vector<wgpu::ConstantEntry>& constants);
+
+    // 录制到 encoder：先经上传带重置 state（indexCount 为 0），再对 [firstMeshlet, firstMeshlet + meshletCount) 做剔除
+    void Record(wgpu::CommandEncoder encoder, UploadBelt& belt, uint32_t firstMeshlet, uint32_t meshletCount, uint32_t uniformOffset);
+
+private:
+    wgpu::Device device = nullptr;
+    wgpu::ComputePipeline pipeline = nullptr;
+    wgpu::BindGroupLayout layoutBindGroup = nullptr;
+    wgpu::PipelineLayout layoutPipeline = nullptr;
+    wgpu::BindGroup bindGroup = nullptr;
+    BufferAllocation state;
+    uint32_t instanceCount = 0;
+};
@@ -0,0 +1,340 @@
+#include "pipeline-cache.h"
+#include "webgpu-utils.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+// 按字段逐个追加，不直接拷结构体，避免把填充字节和指针值带进 key
+class KeyWriter {
+public:
+    template <typename T>
+    void Put(T value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "POD field expected");
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void PutString(const char* text) {
+        size_t length = text != nullptr ? std::strlen(text) : 0;
+        Put<uint64_t>(length);
+        if (length > 0) {
+            key.append(text, length);
+        }
+    }
+    void PutConstants(size_t count, const WGPUConstantEntry* constants) {
+        Put<uint64_t>(count);
+        for (size_t i = 0; i < count; ++i) {
+            PutString(constants[i].key);
+            Put(constants[i].value);
+        }
+    }
+
+    std::string key;
+};
+
+uint64_t HashKey(const std::string& key) {
+    return hashFnv1a(key.data(), key.size());
+}
+
+double MillisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Map>
+typename Map::mapped_type* Find(Map& map, uint64_t hash, const std::string& key) {
+    auto range = map.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.key == key) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Map>
+void ReleaseAll(Map& map) {
+    for (auto& it : map) {
+        it.second.handle.release();
+    }
+    map.clear();
+}
+
+} // namespace
+
+
+PipelineCache::PipelineCache(wgpu::Device device)
+    : device(device) {
+}
+
+PipelineCache::~PipelineCache() {
+    for (auto& it : renderPipelines) {
+        const PipelineCompiler::Handle& job = it.second.handle;
+        if (job->IsReady() && job->pipeline != nullptr) {
+            job->pipeline.release();
+        }
+    }
+    renderPipelines.clear();
+    ReleaseAll(pipelineLayouts);
+    ReleaseAll(bindGroupLayouts);
+    ReleaseAll(shaderModules);
+}
+
+void PipelineCache::PutObjectId(std::string& key, const void* handle) const {
+    KeyWriter writer;
+    auto it = objectIds.find(handle);
+    if (it != objectIds.end()) {
+        writer.Put<uint8_t>(1);
+        writer.Put(it->second);
+    } else {
+        writer.Put<uint8_t>(0);
+        writer.Put<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+    }
+    key += writer.key;
+}
+
+PipelineCache::Entry<PipelineCompiler::Handle>* PipelineCache::FindRenderPipeline(uint64_t hash, const std::string& key) {
+    auto range = renderPipelines.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.key != key) {
+            continue;
+        }
+        const PipelineCompiler::Handle& job = it->second.handle;
+        if (job->IsReady() && !job->success) {
+            renderPipelines.erase(it);
+            return nullptr;
+        }
+        return &it->second;
+    }
+    return nullptr;
+}
+
+wgpu::ShaderModule PipelineCache::GetShaderModule(const std::string& wgslSource, const char* label) {
+    uint64_t hash = HashKey(wgslSource);
+    if (auto* entry = Find(shaderModules, hash, wgslSource)) {
+        ++stats.shaderHits;
+        return entry->handle;
+    }
+    ++stats.shaderMisses;
+
+    auto start = std::chrono::steady_clock::now();
+    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc;
+    shaderCodeDesc.chain.next = nullptr;
+    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+    shaderCodeDesc.code = wgslSource.c_str();
+    wgpu::ShaderModuleDescriptor shaderDesc;
+#ifdef WEBGPU_BACKEND_WGPU
+    shaderDesc.hintCount = 0;
+    shaderDesc.hints = nullptr;
+#endif
+    shaderDesc.label = label;
+    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    wgpu::ShaderModule shaderModule = device.createShaderModule(shaderDesc);
+    stats.createMillis += MillisSince(start);
+
+    shaderModules.emplace(hash, Entry<wgpu::ShaderModule>{ wgslSource, shaderModule });
+    objectIds[shaderModule] = nextObjectId++;
+    return shaderModule;
+}
+
+void PipelineCache::EvictShaderModule(wgpu::ShaderModule shaderModule) {
+    for (auto it = shaderModules.begin(); it != shaderModules.end(); ++it) {
+        if (it->second.handle == shaderModule) {
+            objectIds.erase(shaderModule);
+            it->second.handle.release();
+            shaderModules.erase(it);
+            return;
+        }
+    }
+}
+
+const ShaderReflection* PipelineCache::GetShaderReflection(const std::string& wgslSource) {
+    uint64_t hash = HashKey(wgslSource);
+    if (auto* entry = Find(reflections, hash, wgslSource)) {
+        return entry->handle.get();
+    }
+    auto reflection = std::make_shared<ShaderReflection>();
+    if (!reflection->Parse(wgslSource)) {
+        return nullptr;
+    }
+    reflections.emplace(hash, Entry<std::shared_ptr<ShaderReflection>>{ wgslSource, reflection });
+    return reflection.get();
+}
+
+wgpu::BindGroupLayout PipelineCache::GetBindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor) {
+    KeyWriter writer;
+    writer.Put<uint64_t>(descriptor.entryCount);
+    for (size_t i = 0; i < descriptor.entryCount; ++i) {
+        const WGPUBindGroupLayoutEntry& entry = descriptor.entries[i];
+        writer.Put(entry.binding);
+        writer.Put<uint32_t>(entry.visibility);
+        writer.Put<uint32_t>(entry.buffer.type);
+        writer.Put<uint32_t>(entry.buffer.hasDynamicOffset);
+        writer.Put(entry.buffer.minBindingSize);
+        writer.Put<uint32_t>(entry.sampler.type);
+        writer.Put<uint32_t>(entry.texture.sampleType);
+        writer.Put<uint32_t>(entry.texture.viewDimension);
+        writer.Put<uint32_t>(entry.texture.multisampled);
+        writer.Put<uint32_t>(entry.storageTexture.access);
+        writer.Put<uint32_t>(entry.storageTexture.format);
+        writer.Put<uint32_t>(entry.storageTexture.viewDimension);
+    }
+    uint64_t hash = HashKey(writer.key);
+    if (auto* entry = Find(bindGroupLayouts, hash, writer.key)) {
+        return entry->handle;
+    }
+    wgpu::BindGroupLayout layout = device.createBindGroupLayout(descriptor);
+    bindGroupLayouts.emplace(hash, Entry<wgpu::BindGroupLayout>{ writer.key, layout });
+    objectIds[layout] = nextObjectId++;
+    return layout;
+}
+
+wgpu::PipelineLayout PipelineCache::GetPipelineLayout(const std::vector<wgpu::BindGroupLayout>& layouts) {
+    KeyWriter writer;
+    writer.Put<uint64_t>(layouts.size());
+    for (const auto& layout : layouts) {
+        PutObjectId(writer.key, layout);
+    }
+    uint64_t hash = HashKey(writer.key);
+    if (auto* entry = Find(pipelineLayouts, hash, writer.key)) {
+        return entry->handle;
+    }
+    wgpu::PipelineLayoutDescriptor descPipelineLayout{};
+    descPipelineLayout.bindGroupLayoutCount = layouts.size();
+    descPipelineLayout.bindGroupLayouts = (WGPUBindGroupLayout*)layouts.data();
+    wgpu::PipelineLayout layout = device.createPipelineLayout(descPipelineLayout);
+    pipelineLayouts.emplace(hash, Entry<wgpu::PipelineLayout>{ writer.key, layout });
+    objectIds[layout] = nextObjectId++;
+    return layout;
+}
+
+std::string PipelineCache::SerializeRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor) const {
+    // label 与 nextInChain 不参与 key
+    KeyWriter writer;
+    PutObjectId(writer.key, descriptor.layout);
+
+    const WGPUVertexState& vertex = descriptor.vertex;
+    PutObjectId(writer.key, vertex.module);
+    writer.PutString(vertex.entryPoint);
+    writer.PutConstants(vertex.constantCount, vertex.constants);
+    writer.Put<uint64_t>(vertex.bufferCount);
+    for (size_t i = 0; i < vertex.bufferCount; ++i) {
+        const WGPUVertexBufferLayout& buffer = vertex.buffers[i];
+        writer.Put(buffer.arrayStride);
+        writer.Put<uint32_t>(buffer.stepMode);
+        writer.Put<uint64_t>(buffer.attributeCount);
+        for (size_t a = 0; a < buffer.attributeCount; ++a) {
+            writer.Put<uint32_t>(buffer.attributes[a].format);
+            writer.Put(buffer.attributes[a].offset);
+            writer.Put(buffer.attributes[a].shaderLocation);
+        }
+    }
+
+    writer.Put<uint32_t>(descriptor.primitive.topology);
+    writer.Put<uint32_t>(descriptor.primitive.stripIndexFormat);
+    writer.Put<uint32_t>(descriptor.primitive.frontFace);
+    writer.Put<uint32_t>(descriptor.primitive.cullMode);
+
+    writer.Put<uint32_t>(descriptor.depthStencil != nullptr);
+    if (descriptor.depthStencil != nullptr) {
+        const WGPUDepthStencilState& depth = *descriptor.depthStencil;
+        writer.Put<uint32_t>(depth.format);
+        writer.Put<uint32_t>(depth.depthWriteEnabled);
+        writer.Put<uint32_t>(depth.depthCompare);
+        for (const WGPUStencilFaceState* face : { &depth.stencilFront, &depth.stencilBack }) {
+            writer.Put<uint32_t>(face->compare);
+            writer.Put<uint32_t>(face->failOp);
+            writer.Put<uint32_t>(face->depthFailOp);
+            writer.Put<uint32_t>(face->passOp);
+        }
+        writer.Put(depth.stencilReadMask);
+        writer.Put(depth.stencilWriteMask);
+        writer.Put(depth.depthBias);
+        writer.Put(depth.depthBiasSlopeScale);
+        writer.Put(depth.depthBiasClamp);
+    }
+
+    writer.Put(descriptor.multisample.count);
+    writer.Put(descriptor.multisample.mask);
+    writer.Put<uint32_t>(descriptor.multisample.alphaToCoverageEnabled);
+
+    writer.Put<uint32_t>(descriptor.fragment != nullptr);
+    if (descriptor.fragment != nullptr) {
+        const WGPUFragmentState& fragment = *descriptor.fragment;
+        PutObjectId(writer.key, fragment.module);
+        writer.PutString(fragment.entryPoint);
+        writer.PutConstants(fragment.constantCount, fragment.constants);
+        writer.Put<uint64_t>(fragment.targetCount);
+        for (size_t i = 0; i < fragment.targetCount; ++i) {
+            const WGPUColorTargetState& target = fragment.targets[i];
+            writer.Put<uint32_t>(target.format);
+            writer.Put<uint32_t>(target.writeMask);
+            writer.Put<uint32_t>(target.blend != nullptr);
+            if (target.blend != nullptr) {
+                for (const WGPUBlendComponent* component : { &target.blend->color, &target.blend->alpha }) {
+                    writer.Put<uint32_t>(component->operation);
+                    writer.Put<uint32_t>(component->srcFactor);
+                    writer.Put<uint32_t>(component->dstFactor);
+                }
+            }
+        }
+    }
+    return writer.key;
+}
+
+uint64_t PipelineCache::HashRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor) const {
+    return HashKey(SerializeRenderPipeline(descriptor));
+}
+
+wgpu::RenderPipeline PipelineCache::GetRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor) {
+    std::string key = SerializeRenderPipeline(descriptor);
+    uint64_t hash = HashKey(key);
+    if (auto* entry = FindRenderPipeline(hash, key)) {
+        ++stats.pipelineHits;
+        if (!entry->handle->IsReady()) {
+            asyncCompiler->Wait(entry->handle);
+        }
+        return entry->handle->pipeline;
+    }
+    ++stats.pipelineMisses;
+
+    auto start = std::chrono::steady_clock::now();
+    wgpu::RenderPipeline pipeline = device.createRenderPipeline(descriptor);
+    stats.createMillis += MillisSince(start);
+    renderPipelines.emplace(hash, Entry<PipelineCompiler::Handle>{ std::move(key), PipelineCompiler::MakeReady(pipeline) });
+    return pipeline;
+}
+
+void PipelineCache::EvictRenderPipeline(wgpu::RenderPipeline pipeline) {
+    for (auto it = renderPipelines.begin(); it != renderPipelines.end(); ++it) {
+        const PipelineCompiler::Handle& job = it->second.handle;
+        if (job->IsReady() && job->pipeline == pipeline) {
+            job->pipeline.release();
+            renderPipelines.erase(it);
+            return;
+        }
+    }
+}
+
+PipelineCompiler::Handle PipelineCache::GetRenderPipelineAsync(const wgpu::RenderPipelineDescriptor& descriptor, PipelineCompiler& compiler) {
+    std::string key = SerializeRenderPipeline(descriptor);
+    uint64_t hash = HashKey(key);
+    if (auto* entry = FindRenderPipeline(hash, key)) {
+        ++stats.pipelineHits;
+        return entry->handle;
+    }
+    ++stats.pipelineMisses;
+    ++stats.asyncCompiles;
+
+    asyncCompiler = &compiler;
+    PipelineCompiler::Handle job = compiler.Compile(descriptor);
+    renderPipelines.emplace(hash, Entry<PipelineCompiler::Handle>{ std::move(key), job });
+    return job;
+}
+
+void PipelineCache::PrintStats() const {
+    std::cout << "Pipeline cache: " << stats.pipelineHits << " hits, " << stats.pipelineMisses << " misses"
+              << " (" << stats.asyncCompiles << " async, shaders " << stats.shaderHits << "/" << stats.shaderMisses << "), "
+              << stats.createMillis << " ms creating" << std::endl;
+}
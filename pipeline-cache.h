@@ -0,0 +1,79 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "pipeline-compiler.h"
+#include "shader-reflection.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// 渲染管线缓存：把 RenderPipelineDescriptor 的全部状态（shader module、入口、常量、顶点布局、图元、深度模板、
+// 多重采样、颜色目标格式与混合）序列化后做 FNV-1a 哈希，命中就直接返回已有的 pipeline，不再编译。
+// shader module、bind group layout、pipeline layout 也从这里取，它们按完整内容（源码 / 布局描述）去重，
+// 同样的内容只有一个对象；pipeline 的 key 里记的是对象的编号（创建时分配，永不复用），哈希碰撞时完整比较也能分开。
+// 不是从缓存里取的句柄只能按指针区分。编译失败的 pipeline 不留在缓存里，下次同样的请求会重新编译。
+// 缓存拥有返回的所有对象（包括异步编译出来的 pipeline），调用方不要 release。
+class PipelineCache {
+public:
+    struct Stats {
+        uint32_t pipelineHits = 0;
+        uint32_t pipelineMisses = 0;
+        uint32_t shaderHits = 0;
+        uint32_t shaderMisses = 0;
+        uint32_t asyncCompiles = 0;     // 未命中里交给 PipelineCompiler 的个数
+        double createMillis = 0.0;      // miss 时在调用线程上创建 module/pipeline 花掉的总时间（不含异步编译）
+    };
+
+    explicit PipelineCache(wgpu::Device device);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    wgpu::ShaderModule GetShaderModule(const std::string& wgslSource, const char* label = nullptr);
+    // 丢掉一个无法编译的 module，之后同样的源码会重新创建（热重载时用）
+    void EvictShaderModule(wgpu::ShaderModule shaderModule);
+    // 源码的反射结果，与 module 一样按源码哈希缓存；解析失败返回 nullptr（不缓存）
+    const ShaderReflection* GetShaderReflection(const std::string& wgslSource);
+    wgpu::BindGroupLayout GetBindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor);
+    wgpu::PipelineLayout GetPipelineLayout(const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts);
+    wgpu::RenderPipeline GetRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor);
+    // 丢掉一个创建时报了错的 pipeline，之后同样的描述会重新创建
+    void EvictRenderPipeline(wgpu::RenderPipeline pipeline);
+    // 未命中时交给 compiler 在后台编译；命中（包括同一描述正在编译中）直接返回同一个 job。
+    // compiler 必须先于缓存析构（它会等在途的编译完成）
+    PipelineCompiler::Handle GetRenderPipelineAsync(const wgpu::RenderPipelineDescriptor& descriptor, PipelineCompiler& compiler);
+
+    // 与 GetRenderPipeline 使用的 key 相同，可用于判断两个描述是否会得到同一个 pipeline
+    uint64_t HashRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor) const;
+
+    const Stats& GetStats() const { return stats; }
+    void PrintStats() const;
+
+private:
+    template <typename Handle>
+    struct Entry {
+        std::string key;        // 完整的序列化状态，哈希相同时再比较一次，碰撞的条目并存
+        Handle handle = nullptr;
+    };
+
+    std::string SerializeRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor) const;
+    // 往 key 里追加对象的身份：缓存创建的对象写它的编号，外来句柄写指针值（两者用一个字节区分）
+    void PutObjectId(std::string& key, const void* handle) const;
+    // 命中的 pipeline 条目；已经编译失败的条目顺手删掉，当作未命中
+    Entry<PipelineCompiler::Handle>* FindRenderPipeline(uint64_t hash, const std::string& key);
+
+private:
+    wgpu::Device device = nullptr;
+    Stats stats;
+    std::unordered_multimap<uint64_t, Entry<wgpu::ShaderModule>> shaderModules;
+    std::unordered_multimap<uint64_t, Entry<std::shared_ptr<ShaderReflection>>> reflections;
+    std::unordered_multimap<uint64_t, Entry<wgpu::BindGroupLayout>> bindGroupLayouts;
+    std::unordered_multimap<uint64_t, Entry<wgpu::PipelineLayout>> pipelineLayouts;
+    std::unordered_multimap<uint64_t, Entry<PipelineCompiler::Handle>> renderPipelines; // 同步创建的也包装成已完成的 job
+    PipelineCompiler* asyncCompiler = nullptr;  // 同步请求撞上正在编译的条目时用它等待
+    std::unordered_map<const void*, uint64_t> objectIds;   // 句柄 -> 编号
+    uint64_t nextObjectId = 1;
+};
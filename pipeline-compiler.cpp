@@ -0,0 +1,291 @@
+#include "pipeline-compiler.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#ifdef __EMSCRIPTEN__
+#  include <emscripten.h>
+#endif
+
+#if defined(WEBGPU_BACKEND_DAWN) || defined(__EMSCRIPTEN__)
+#define PIPELINE_COMPILER_NATIVE_ASYNC 1
+#endif
+#ifndef __EMSCRIPTEN__
+#define PIPELINE_COMPILER_WORKER 1
+#endif
+
+namespace {
+
+double MillisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 后台线程正在编译的 job 的名字与是否出错；其他线程上为空
+struct CompilingState {
+    const std::string* label = nullptr;
+    bool failed = false;
+};
+thread_local CompilingState compiling;
+
+} // namespace
+
+
+// RenderPipelineDescriptor 里全是指针，交给别的线程之前把它们指向的数据都拷一份
+struct PipelineCompiler::Request {
+    Handle job;
+    std::chrono::steady_clock::time_point start;
+    Prepare prepare;                                // 非空时由它填 descriptor，下面的拷贝都不用
+
+    wgpu::RenderPipelineDescriptor descriptor;
+    std::string label;
+    std::string vertexEntry;
+    std::string fragmentEntry;
+    std::deque<std::string> constantKeys;           // deque : push_back 不会让之前的 c_str() 失效
+    std::vector<WGPUConstantEntry> vertexConstants;
+    std::vector<WGPUConstantEntry> fragmentConstants;
+    std::vector<WGPUVertexBufferLayout> buffers;
+    std::vector<std::vector<WGPUVertexAttribute>> attributes;
+    WGPUDepthStencilState depthStencil = {};
+    WGPUFragmentState fragment = {};
+    std::vector<WGPUColorTargetState> targets;
+    std::vector<WGPUBlendState> blends;
+
+    void CopyConstants(size_t count, const WGPUConstantEntry* source, std::vector<WGPUConstantEntry>& target) {
+        target.assign(source, source + count);
+        for (auto& constant : target) {
+            constantKeys.push_back(constant.key != nullptr ? constant.key : "");
+            constant.key = constantKeys.back().c_str();
+        }
+    }
+
+    Request(const std::string& label, Prepare prepare)
+        : prepare(std::move(prepare)), label(label) {
+    }
+
+    explicit Request(const wgpu::RenderPipelineDescriptor& source) {
+        descriptor = source;
+        descriptor.nextInChain = nullptr;
+        label = source.label != nullptr ? source.label : "";
+        descriptor.label = label.c_str();
+
+        vertexEntry = source.vertex.entryPoint != nullptr ? source.vertex.entryPoint : "";
+        descriptor.vertex.entryPoint = vertexEntry.c_str();
+        CopyConstants(source.vertex.constantCount, source.vertex.constants, vertexConstants);
+        descriptor.vertex.constants = vertexConstants.data();
+        buffers.assign(source.vertex.buffers, source.vertex.buffers + source.vertex.bufferCount);
+        attributes.resize(buffers.size());
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            attributes[i].assign(buffers[i].attributes, buffers[i].attributes + buffers[i].attributeCount);
+            buffers[i].attributes = attributes[i].data();
+        }
+        descriptor.vertex.buffers = buffers.data();
+
+        if (source.depthStencil != nullptr) {
+            depthStencil = *source.depthStencil;
+            descriptor.depthStencil = &depthStencil;
+        }
+
+        if (source.fragment != nullptr) {
+            fragment = *source.fragment;
+            fragmentEntry = fragment.entryPoint != nullptr ? fragment.entryPoint : "";
+            fragment.entryPoint = fragmentEntry.c_str();
+            CopyConstants(fragment.constantCount, fragment.constants, fragmentConstants);
+            fragment.constants = fragmentConstants.data();
+            targets.assign(fragment.targets, fragment.targets + fragment.targetCount);
+            blends.resize(targets.size());
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if (targets[i].blend != nullptr) {
+                    blends[i] = *targets[i].blend;
+                    targets[i].blend = &blends[i];
+                }
+            }
+            fragment.targets = targets.data();
+            descriptor.fragment = &fragment;
+        }
+    }
+};
+
+
+PipelineCompiler::PipelineCompiler(wgpu::Device device)
+    : device(device) {
+#ifdef PIPELINE_COMPILER_WORKER
+    running = true;
+    worker = std::thread(&PipelineCompiler::WorkerThread, this);
+#endif // PIPELINE_COMPILER_WORKER
+}
+
+PipelineCompiler::~PipelineCompiler() {
+#ifdef PIPELINE_COMPILER_WORKER
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    if (worker.joinable()) {
+        worker.join(); // 队列里剩下的请求会先处理完
+    }
+#endif // PIPELINE_COMPILER_WORKER
+#ifdef PIPELINE_COMPILER_NATIVE_ASYNC
+    // 回调由 tick / 浏览器事件循环交付，等它们全部回来，回调里才不会访问已析构的对象
+    while (pendingCount > 0) {
+#if defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#elif defined(__EMSCRIPTEN__)
+        emscripten_sleep(1);
+#endif
+    }
+#endif // PIPELINE_COMPILER_NATIVE_ASYNC
+}
+
+PipelineCompiler::Handle PipelineCompiler::MakeReady(wgpu::RenderPipeline pipeline) {
+    Handle job = std::make_shared<Job>();
+    job->success = pipeline != nullptr;
+    job->pipeline = pipeline;
+    job->ready = true;
+    return job;
+}
+
+bool PipelineCompiler::CaptureError(wgpu::ErrorType type, char const* message) {
+    if (compiling.label == nullptr) {
+        return false;
+    }
+    std::cout << "Pipeline '" << *compiling.label << "' failed to compile: " << (message ? message : "")
+              << " (" << type << ")" << std::endl;
+    compiling.failed = true;
+    return true;
+}
+
+PipelineCompiler::Handle PipelineCompiler::Compile(const wgpu::RenderPipelineDescriptor& descriptor) {
+    Handle job = std::make_shared<Job>();
+    job->label = descriptor.label != nullptr ? descriptor.label : "";
+    ++pendingCount;
+    auto start = std::chrono::steady_clock::now();
+
+#ifdef PIPELINE_COMPILER_NATIVE_ASYNC
+    CompileAsync(job, descriptor, start);
+#else
+    auto request = std::make_unique<Request>(descriptor);
+    request->job = job;
+    request->start = start;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(std::move(request));
+    }
+    wakeUp.notify_all();
+#endif // PIPELINE_COMPILER_NATIVE_ASYNC
+    return job;
+}
+
+PipelineCompiler::Handle PipelineCompiler::Compile(const std::string& label, Prepare prepare) {
+    Handle job = std::make_shared<Job>();
+    job->label = label;
+    ++pendingCount;
+
+    auto request = std::make_unique<Request>(label, std::move(prepare));
+    request->job = job;
+    request->start = std::chrono::steady_clock::now();
+#ifdef PIPELINE_COMPILER_WORKER
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(std::move(request));
+    }
+    wakeUp.notify_all();
+#else
+    Process(*request);
+#endif // PIPELINE_COMPILER_WORKER
+    return job;
+}
+
+void PipelineCompiler::CompileAsync(const Handle& job, const wgpu::RenderPipelineDescriptor& descriptor,
+                                    std::chrono::steady_clock::time_point start) {
+    // descriptor 只需在调用期间有效
+    Job* raw = job.get();
+    job->asyncHandle = device.createRenderPipelineAsync(descriptor,
+        [this, raw, start](wgpu::CreatePipelineAsyncStatus status, wgpu::RenderPipeline pipeline, char const* message) {
+            bool success = status == wgpu::CreatePipelineAsyncStatus::Success;
+            if (!success) {
+                std::cout << "Pipeline '" << raw->label << "' failed to compile: " << (message ? message : "") << std::endl;
+            }
+            Finish(*raw, success, pipeline, start);
+        });
+}
+
+void PipelineCompiler::Finish(Job& job, bool success, wgpu::RenderPipeline pipeline, std::chrono::steady_clock::time_point start) {
+    job.success = success && pipeline != nullptr;
+    job.pipeline = job.success ? pipeline : nullptr;
+    job.compileMillis = MillisSince(start);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.ready.store(true, std::memory_order_release);
+    }
+    --pendingCount;
+    wakeUp.notify_all();
+}
+
+void PipelineCompiler::Wait(const Handle& job) {
+#ifdef PIPELINE_COMPILER_NATIVE_ASYNC
+    while (!job->IsReady()) {
+#if defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#elif defined(__EMSCRIPTEN__)
+        emscripten_sleep(1);
+#endif
+    }
+#else
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeUp.wait(lock, [&job]() { return job->IsReady(); });
+#endif // PIPELINE_COMPILER_NATIVE_ASYNC
+}
+
+void PipelineCompiler::WorkerThread() {
+    while (true) {
+        std::unique_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this]() { return !running || !requests.empty(); });
+            if (requests.empty()) {
+                break; // !running 且没有剩余请求
+            }
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+        Process(*request);
+    }
+}
+
+void PipelineCompiler::Process(Request& request) {
+    // wgpu-native 的 Device 可以跨线程使用。wgpu-native 出错时仍返回一个无效的对象，
+    // 错误经 uncaptured error 回调（在本线程上同步调用）交给 CaptureError 记下
+    wgpu::RenderPipeline pipeline = nullptr;
+    bool valid = true;
+    {
+        std::lock_guard<std::mutex> scopeLock(errorScopeMutex);
+        compiling = { &request.label, false };
+        if (request.prepare && !request.prepare(request.descriptor)) {
+            valid = false;
+        }
+        valid = valid && !compiling.failed;
+#ifdef PIPELINE_COMPILER_NATIVE_ASYNC
+        if (valid) {
+            CompileAsync(request.job, request.descriptor, request.start);
+        }
+#else
+        if (valid) {
+            pipeline = device.createRenderPipeline(request.descriptor);
+            valid = !compiling.failed;
+        }
+#endif // PIPELINE_COMPILER_NATIVE_ASYNC
+        compiling = {};
+    }
+#ifdef PIPELINE_COMPILER_NATIVE_ASYNC
+    if (valid) {
+        return; // CompileAsync 的回调里 Finish
+    }
+#endif // PIPELINE_COMPILER_NATIVE_ASYNC
+    if (!valid && pipeline != nullptr) {
+        pipeline.release();
+        pipeline = nullptr;
+    }
+    Finish(*request.job, pipeline != nullptr, pipeline, request.start);
+}
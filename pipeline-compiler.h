@@ -0,0 +1,83 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 渲染管线的异步编译。createRenderPipeline 会同步编译 shader，新材质变体第一次出现时卡住渲染线程几百毫秒；
+// 这里把编译挪走：Dawn / emscripten 用 createRenderPipelineAsync，wgpu-native（没有实现 async 版本）用一个后台线程。
+// Compile() 立即返回一个 Job 句柄，渲染线程每帧看一眼 IsReady()，好了再换上，期间继续用占位 pipeline。
+// wgpu-native 的错误作用域是整个 device 共用的一个栈，后台线程不 push 作用域：编译出错时 wgpu-native 在出错的线程上
+// 同步调用 uncaptured error 回调，回调里先交给 CaptureError 认领；渲染线程自己的 push/pop 要在 LockErrorScopes 下做，
+// 免得后台编译的错误落进渲染线程的作用域里。
+// 带 prepare 的 Compile 把读文件、预处理、反射、创建 shader module 这些准备工作也放到编译线程上（热重载用），
+// Dawn 下编译线程随后调用 createRenderPipelineAsync（需开启 ImplicitDeviceSynchronization）；emscripten 没有线程，prepare 在调用线程上执行。
+class PipelineCompiler {
+public:
+    struct Job {
+        std::string label;
+        bool success = false;
+        wgpu::RenderPipeline pipeline = nullptr;    // ready 之后有效；由调用方（或 PipelineCache）负责 release
+        double compileMillis = 0.0;                 // 从提交到完成
+
+        bool IsReady() const { return ready.load(std::memory_order_acquire); }
+
+    private:
+        friend class PipelineCompiler;
+        std::atomic<bool> ready{ false };
+        std::unique_ptr<wgpu::CreateRenderPipelineAsyncCallback> asyncHandle;
+    };
+    using Handle = std::shared_ptr<Job>;
+
+    explicit PipelineCompiler(wgpu::Device device);
+    // 等所有已提交的编译完成
+    ~PipelineCompiler();
+
+    PipelineCompiler(const PipelineCompiler&) = delete;
+    PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+    // descriptor 会被深拷贝，调用返回后即可销毁；其中引用的 module / layout 需存活到编译完成
+    Handle Compile(const wgpu::RenderPipelineDescriptor& descriptor);
+    // 在编译线程上先调用 prepare 填好 descriptor 再编译。descriptor 指向的数据由 prepare 自己持有（放在它捕获的对象里），
+    // prepare 对象在编译完成后才析构。prepare 返回 false，或期间 device 报了错，job 就失败
+    using Prepare = std::function<bool(wgpu::RenderPipelineDescriptor& descriptor)>;
+    Handle Compile(const std::string& label, Prepare prepare);
+    // 阻塞到 job 完成（例如退出前，或同步路径需要结果时）
+    void Wait(const Handle& job);
+    uint32_t GetPendingCount() const { return pendingCount.load(); }
+
+    // 已完成的 job，不经编译（缓存命中时用）
+    static Handle MakeReady(wgpu::RenderPipeline pipeline);
+
+    // 在 device 的 uncaptured error 回调里先调用：当前线程正在编译时把错误记到那个 job 上并返回 true
+    static bool CaptureError(wgpu::ErrorType type, char const* message);
+    // 渲染线程 pushErrorScope ... popErrorScope 期间持有，后台线程在这期间不开始编译
+    std::unique_lock<std::mutex> LockErrorScopes() { return std::unique_lock<std::mutex>(errorScopeMutex); }
+
+private:
+    struct Request;
+    void Finish(Job& job, bool success, wgpu::RenderPipeline pipeline, std::chrono::steady_clock::time_point start);
+    // 调用 createRenderPipelineAsync，完成时在回调里 Finish
+    void CompileAsync(const Handle& job, const wgpu::RenderPipelineDescriptor& descriptor, std::chrono::steady_clock::time_point start);
+    // 执行 prepare（有的话）并编译：wgpu-native 同步编译后 Finish，Dawn / emscripten 交给 CompileAsync
+    void Process(Request& request);
+    void WorkerThread();
+
+private:
+    wgpu::Device device = nullptr;
+    std::atomic<uint32_t> pendingCount{ 0 };
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;     // 有新请求 / 有 job 完成
+    std::deque<std::unique_ptr<Request>> requests;
+    bool running = false;
+    std::thread worker;
+    std::mutex errorScopeMutex;         // 后台线程 createRenderPipeline 期间持有
+};
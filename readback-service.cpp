@@ -0,0 +1,255 @@
+#include "readback-service.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+
+namespace {
+
+const uint64_t kMinStagingSize = 256;
+const size_t kMaxPooledStaging = 16;   // 池子里最多留多少个空闲暂存 buffer
+
+uint64_t RoundUpPow2(uint64_t size) {
+    uint64_t bucket = kMinStagingSize;
+    while (bucket < size) {
+        bucket <<= 1;
+    }
+    return bucket;
+}
+
+} // namespace
+
+
+ReadbackService::ReadbackService(wgpu::Device device, wgpu::Queue queue)
+    : device(device), queue(queue) {
+    running = true;
+#ifndef __EMSCRIPTEN__
+    pollThread = std::thread(&ReadbackService::PollThread, this);
+#endif // __EMSCRIPTEN__
+    // emscripten 下没有线程，map 回调由浏览器的事件循环交付
+}
+
+ReadbackService::~ReadbackService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    if (pollThread.joinable()) {
+        pollThread.join(); // poll 线程会先把在途的回读全部交付再退出
+    }
+    CollectFinished();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& it : freeStaging) {
+        it.second.destroy();
+        it.second.release();
+    }
+    freeStaging.clear();
+}
+
+wgpu::Buffer ReadbackService::AcquireStaging(uint64_t size, uint64_t& stagingSize) {
+    stagingSize = RoundUpPow2(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = freeStaging.find(stagingSize);
+        if (it != freeStaging.end()) {
+            wgpu::Buffer staging = it->second;
+            freeStaging.erase(it);
+            return staging;
+        }
+    }
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Readback staging buffer";
+    bufferDesc.size = stagingSize;
+    bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    bufferDesc.mappedAtCreation = false;
+    return device.createBuffer(bufferDesc);
+}
+
+void ReadbackService::ReleaseStaging(wgpu::Buffer staging, uint64_t stagingSize) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeStaging.size() < kMaxPooledStaging) {
+            freeStaging.emplace(stagingSize, staging);
+            return;
+        }
+    }
+    staging.destroy();
+    staging.release();
+}
+
+void ReadbackService::ReadBuffer(wgpu::Buffer src, uint64_t offset, uint64_t size, Callback callback) {
+    CollectFinished();
+
+    auto request = std::make_unique<Request>();
+    request->size = size;
+    request->callback = std::move(callback);
+    // copyBufferToBuffer / mapAsync 要求大小是 4 的倍数
+    uint64_t copySize = (size + 3) & ~uint64_t(3);
+    request->staging = AcquireStaging(copySize, request->stagingSize);
+
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+    encoder.copyBufferToBuffer(src, offset, request->staging, 0, copySize);
+    Submit(encoder, std::move(request));
+}
+
+void ReadbackService::ReadTexture(wgpu::Texture texture, uint32_t width, uint32_t height, uint32_t bytesPerPixel, Callback callback) {
+    CollectFinished();
+
+    auto request = std::make_unique<Request>();
+    request->rowBytes = width * bytesPerPixel;
+    request->paddedRowBytes = (request->rowBytes + 255) & ~255u; // bytesPerRow 必须是 256 的倍数
+    request->rowCount = height;
+    request->size = static_cast<uint64_t>(request->rowBytes) * height;
+    request->callback = std::move(callback);
+    request->staging = AcquireStaging(static_cast<uint64_t>(request->paddedRowBytes) * height, request->stagingSize);
+
+    wgpu::ImageCopyTexture source;
+    source.texture = texture;
+    source.mipLevel = 0;
+    source.origin = { 0, 0, 0 };
+    source.aspect = wgpu::TextureAspect::All;
+
+    wgpu::ImageCopyBuffer destination;
+    destination.buffer = request->staging;
+    destination.layout.offset = 0;
+    destination.layout.bytesPerRow = request->paddedRowBytes;
+    destination.layout.rowsPerImage = height;
+
+    wgpu::CommandEncoder encoder = device.createCommandEncoder(wgpu::Default);
+    encoder.copyTextureToBuffer(source, destination, wgpu::Extent3D(width, height, 1));
+    Submit(encoder, std::move(request));
+}
+
+std::future<ReadbackService::Result> ReadbackService::ReadBuffer(wgpu::Buffer src, uint64_t offset, uint64_t size) {
+    return MakeFuture([&](Callback callback) { ReadBuffer(src, offset, size, std::move(callback)); });
+}
+
+std::future<ReadbackService::Result> ReadbackService::ReadTexture(wgpu::Texture texture, uint32_t width, uint32_t height, uint32_t bytesPerPixel) {
+    return MakeFuture([&](Callback callback) { ReadTexture(texture, width, height, bytesPerPixel, std::move(callback)); });
+}
+
+std::future<ReadbackService::Result> ReadbackService::MakeFuture(const std::function<void(Callback)>& issue) {
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    issue([promise](bool success, const uint8_t* data, uint64_t size) {
+        Result result;
+        result.success = success;
+        if (success) {
+            result.data.assign(data, data + size);
+        }
+        promise->set_value(std::move(result));
+    });
+    return future;
+}
+
+void ReadbackService::Submit(wgpu::CommandEncoder encoder, std::unique_ptr<Request> request) {
+    wgpu::CommandBuffer command = encoder.finish(wgpu::Default);
+    encoder.release();
+    queue.submit(1, &command);
+    command.release();
+
+    Request* raw = request.get();
+    uint64_t mapSize = raw->rowCount > 0
+        ? static_cast<uint64_t>(raw->paddedRowBytes) * raw->rowCount
+        : ((raw->size + 3) & ~uint64_t(3));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(std::move(request));
+        ++pendingCount;
+    }
+    // 复制命令已经提交，可以立刻请求映射，映射会在复制执行完之后才完成
+    // 不持锁调用：出错时 mapAsync 可能同步触发回调
+    auto handle = raw->staging.mapAsync(wgpu::MapMode::Read, 0, mapSize, [this, raw](wgpu::BufferMapAsyncStatus status) {
+        OnMapped(raw, status);
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        raw->mapHandle = std::move(handle);
+    }
+    wakeUp.notify_all();
+}
+
+void ReadbackService::OnMapped(Request* request, wgpu::BufferMapAsyncStatus status) {
+    bool success = status == wgpu::BufferMapAsyncStatus::Success;
+    if (!success) {
+        std::cout << "Readback map failed, status=" << (int)status << std::endl;
+    }
+    if (success && request->rowCount > 0) {
+        uint64_t mapSize = static_cast<uint64_t>(request->paddedRowBytes) * request->rowCount;
+        const uint8_t* mapped = (const uint8_t*)request->staging.getConstMappedRange(0, mapSize);
+        if (request->paddedRowBytes == request->rowBytes) {
+            request->callback(true, mapped, request->size);
+        } else {
+            // 去掉每行末尾的对齐填充
+            std::vector<uint8_t> packed(request->size);
+            for (uint32_t row = 0; row < request->rowCount; ++row) {
+                std::memcpy(packed.data() + static_cast<size_t>(row) * request->rowBytes,
+                            mapped + static_cast<size_t>(row) * request->paddedRowBytes,
+                            request->rowBytes);
+            }
+            request->callback(true, packed.data(), request->size);
+        }
+    } else if (success) {
+        uint64_t mapSize = (request->size + 3) & ~uint64_t(3);
+        const uint8_t* mapped = (const uint8_t*)request->staging.getConstMappedRange(0, mapSize);
+        request->callback(true, mapped, request->size);
+    } else {
+        request->callback(false, nullptr, 0);
+    }
+    if (success) {
+        request->staging.unmap();
+    }
+    ReleaseStaging(request->staging, request->stagingSize);
+    request->staging = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        request->done = true;
+    }
+    --pendingCount;
+    wakeUp.notify_all();
+}
+
+void ReadbackService::CollectFinished() {
+    std::list<std::unique_ptr<Request>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = requests.begin(); it != requests.end();) {
+            // mapHandle 还没存进来说明 Submit 还在进行中，下次再清理
+            if ((*it)->done && (*it)->mapHandle != nullptr) {
+                finished.push_back(std::move(*it));
+                it = requests.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // finished 在锁外析构
+}
+
+void ReadbackService::PollThread() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // 没有在途回读时睡眠，不占 CPU
+            wakeUp.wait(lock, [this]() { return !running || pendingCount > 0; });
+            if (!running && pendingCount == 0) {
+                break;
+            }
+        }
+#if defined(WEBGPU_BACKEND_WGPU)
+        // 阻塞到已提交的工作执行完，期间在本线程上触发 map 回调。
+        // poll 会交付 device 上所有待交付的回调（上传带的重新映射、waitForQueueIdle、帧 fence），它们都要能在本线程上执行
+        device.poll(true);
+        std::this_thread::yield();
+#elif defined(WEBGPU_BACKEND_DAWN)
+        // Dawn 需开启 ImplicitDeviceSynchronization 才能跨线程 tick
+        device.tick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+        CollectFinished();
+    }
+}
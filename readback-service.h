@@ -0,0 +1,81 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+// 异步 GPU -> CPU 回读服务，代替 PlayingWithBuffers() 里 `while (!ready) device.poll(true);` 的写法：
+//  - 暂存的 MapRead buffer 放在池子里复用（按 2 的幂分档），可以同时有多个回读在途；
+//  - 复制命令 submit 之后立刻 mapAsync，由专门的 poll 线程推动回调，调用线程（渲染线程）从不空转等待；
+//  - 结果通过回调（在 poll 线程上执行）或 std::future 交付。
+// 源 buffer 需带 CopySrc，offset/size 需为 4 的倍数（copyBufferToBuffer 的要求）。
+class ReadbackService {
+public:
+    struct Result {
+        bool success = false;
+        std::vector<uint8_t> data;
+    };
+    // data 只在回调期间有效（指向映射内存），需要保留就自己拷贝
+    using Callback = std::function<void(bool success, const uint8_t* data, uint64_t size)>;
+
+    ReadbackService(wgpu::Device device, wgpu::Queue queue);
+    ~ReadbackService();
+
+    ReadbackService(const ReadbackService&) = delete;
+    ReadbackService& operator=(const ReadbackService&) = delete;
+
+    void ReadBuffer(wgpu::Buffer src, uint64_t offset, uint64_t size, Callback callback);
+    std::future<Result> ReadBuffer(wgpu::Buffer src, uint64_t offset, uint64_t size);
+
+    // 回读整张 2D 纹理（如截图），texture 需带 CopySrc；结果按行紧密排列（去掉了 256 字节的行对齐填充）
+    void ReadTexture(wgpu::Texture texture, uint32_t width, uint32_t height, uint32_t bytesPerPixel, Callback callback);
+    std::future<Result> ReadTexture(wgpu::Texture texture, uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+
+    // 在途（已提交、尚未交付）的回读数量
+    uint32_t GetPendingCount() const { return pendingCount; }
+
+private:
+    struct Request {
+        wgpu::Buffer staging = nullptr;
+        uint64_t stagingSize = 0;
+        uint64_t size = 0;
+        // 纹理回读时的行信息，用来去掉 bytesPerRow 的对齐填充
+        uint32_t rowBytes = 0;
+        uint32_t paddedRowBytes = 0;
+        uint32_t rowCount = 0;
+        Callback callback;
+        std::unique_ptr<wgpu::BufferMapCallback> mapHandle; // 必须持有到回调结束
+        bool done = false;
+    };
+
+    wgpu::Buffer AcquireStaging(uint64_t size, uint64_t& stagingSize);
+    void ReleaseStaging(wgpu::Buffer staging, uint64_t stagingSize);
+    // 提交已录制好复制命令的 encoder，并对暂存 buffer 发起 mapAsync
+    void Submit(wgpu::CommandEncoder encoder, std::unique_ptr<Request> request);
+    void OnMapped(Request* request, wgpu::BufferMapAsyncStatus status);
+    // 回调执行期间不能销毁它自己的 mapHandle，完成的请求延后到这里清理
+    void CollectFinished();
+    void PollThread();
+
+    static std::future<Result> MakeFuture(const std::function<void(Callback)>& issue);
+
+private:
+    wgpu::Device device = nullptr;
+    wgpu::Queue queue = nullptr;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::list<std::unique_ptr<Request>> requests;
+    std::multimap<uint64_t, wgpu::Buffer> freeStaging; // 档位大小 -> 空闲暂存 buffer
+    std::atomic<uint32_t> pendingCount{ 0 };
+    bool running = false;
+    std::thread pollThread;
+};
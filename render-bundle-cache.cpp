@@ -0,0 +1,61 @@
+#include "render-bundle-cache.h"
+
+#include <cassert>
+
+
+RenderBundleCache::RenderBundleCache(wgpu::Device device, const char* label)
+    : device(device), label(label) {
+}
+
+RenderBundleCache::~RenderBundleCache() {
+    Release();
+}
+
+void RenderBundleCache::Configure(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t variantCount, Recorder recorder) {
+    Release();
+    this->colorFormat = colorFormat;
+    this->depthStencilFormat = depthStencilFormat;
+    this->recorder = std::move(recorder);
+    bundles.assign(variantCount, nullptr);
+}
+
+wgpu::RenderBundle RenderBundleCache::Get(uint32_t variant) {
+    assert(variant < bundles.size());
+    if (bundles[variant] != nullptr) {
+        return bundles[variant];
+    }
+
+    WGPUTextureFormat format = colorFormat;
+    wgpu::RenderBundleEncoderDescriptor encoderDesc;
+    encoderDesc.label = label;
+    encoderDesc.colorFormatCount = 1;
+    encoderDesc.colorFormats = &format;
+    encoderDesc.depthStencilFormat = depthStencilFormat;
+    encoderDesc.sampleCount = 1;
+    encoderDesc.depthReadOnly = false;
+    encoderDesc.stencilReadOnly = false;
+    wgpu::RenderBundleEncoder encoder = device.createRenderBundleEncoder(encoderDesc);
+
+    recorder(encoder, variant);
+
+    wgpu::RenderBundleDescriptor bundleDesc;
+    bundleDesc.label = label;
+    bundles[variant] = encoder.finish(bundleDesc);
+    encoder.release();
+    ++recordCount;
+    return bundles[variant];
+}
+
+void RenderBundleCache::Invalidate() {
+    for (auto& bundle : bundles) {
+        if (bundle != nullptr) {
+            bundle.release();
+            bundle = nullptr;
+        }
+    }
+}
+
+void RenderBundleCache::Release() {
+    Invalidate();
+    bundles.clear();
+}
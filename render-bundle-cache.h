@@ -0,0 +1,42 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <vector>
+#include <functional>
+
+// 把每帧都一样的绘制序列（setPipeline/setVertexBuffer/setIndexBuffer/setBindGroup/draw）预先录成 wgpu::RenderBundle，
+// 每帧只需 renderPass.executeBundles，省掉 CPU 端逐条编码与校验的开销。
+// bundle 里录下的是具体的 buffer/bindGroup/动态偏移，所以：
+//  - 动态偏移不同就是不同的 bundle，用 variant 区分（如每个 frame slot 一份）
+//  - 引用的资源重建后要 Invalidate()，下次 Get() 时重新录制
+class RenderBundleCache {
+public:
+    using Recorder = std::function<void(wgpu::RenderBundleEncoder encoder, uint32_t variant)>;
+
+    RenderBundleCache(wgpu::Device device, const char* label);
+    ~RenderBundleCache();
+
+    RenderBundleCache(const RenderBundleCache&) = delete;
+    RenderBundleCache& operator=(const RenderBundleCache&) = delete;
+
+    // 目标格式必须与执行它的 render pass 一致；重新配置会丢掉已录制的 bundle
+    void Configure(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t variantCount, Recorder recorder);
+    // 没有录制过（或已失效）就现录一份
+    wgpu::RenderBundle Get(uint32_t variant);
+    void Invalidate();
+
+    // 录制次数，用来确认静态场景确实没有每帧重录
+    uint32_t GetRecordCount() const { return recordCount; }
+
+private:
+    void Release();
+
+private:
+    wgpu::Device device = nullptr;
+    const char* label = nullptr;
+    wgpu::TextureFormat colorFormat = wgpu::TextureFormat::Undefined;
+    wgpu::TextureFormat depthStencilFormat = wgpu::TextureFormat::Undefined;
+    Recorder recorder;
+    std::vector<wgpu::RenderBundle> bundles;    // 下标即 variant，nullptr 表示需要重录
+    uint32_t recordCount = 0;
+};
@@ -0,0 +1,38 @@
+// quad 着色器各变体共用的声明
+
+// 每帧的 uniform（动态偏移选中本帧那一份）。会在运行时变化的值放这里，改了不用重编 pipeline
+struct ViewUniforms {
+    time : f32,
+    aspect : f32,   // 渲染目标的 宽 / 高，y 乘上它让正方形显示为正；窗口缩放时随之更新
+};
+
+@group(0) @binding(0)
+var<uniform> uView : ViewUniforms;
+
+// 每个网格一份：顶点位置可能量化成 snorm16 / unorm16，按包围盒还原
+struct MeshUniforms {
+    positionScale : vec4f,
+    positionOffset : vec4f,
+};
+
+@group(0) @binding(1)
+var<uniform> uMesh : MeshUniforms;
+
+fn decodePosition(quantized : vec2f) -> vec2f {
+    return quantized * uMesh.positionScale.xy + uMesh.positionOffset.xy;
+}
+
+// 位置+颜色 的顶点属性结构，作为顶点着色器的输入参数
+struct VertexInput {
+    @location(0) position : vec2f,
+    @location(1) color : vec3f,
+};
+
+// 每个实例一份（VertexStepMode::Instance）：中心位置、缩放、动画相位、深度、颜色
+struct InstanceInput {
+    @location(2) offset : vec2f,
+    @location(3) scale : f32,
+    @location(4) phase : f32,
+    @location(5) depth : f32,   // 整个正方形在同一深度，[0, 1]，越小越近
+    @location(6) tint : vec4f,
+};
@@ -0,0 +1,50 @@
+// 变体：
+//   PLACEHOLDER  正式 pipeline 编译期间用的占位版本：不做动画，灰色
+#include "quad-common.wgsl"
+
+#if PLACEHOLDER
+
+@vertex
+fn vs_main(in: VertexInput, instance: InstanceInput) -> @builtin(position) vec4f {
+    let position = instance.offset + decodePosition(in.position) * instance.scale;
+    return vec4f(position.x, position.y * uView.aspect, instance.depth, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4f {
+    return vec4f(0.5, 0.5, 0.5, 1.0);
+}
+
+#else
+
+// 顶点着色器的输出 & 片段着色器的输入
+struct VertexOutput {
+    @builtin(position) position : vec4f,
+    @location(0) color : vec3f,
+};
+
+// 特化常量：由 pipeline 的 constants 在创建时给定，编译器可以直接折叠进顶点着色器；
+// 不同取值是不同的 pipeline，由 PipelineCache 按 constants 分别缓存
+override orbitRadius : f32 = 0.3;
+override animate : bool = true;
+
+@vertex 
+fn vs_main(in: VertexInput, instance: InstanceInput) -> VertexOutput {
+    var centre = instance.offset;
+    // 以实例中心为圆心，半径为 orbitRadius * scale 的圆 上面的点；各实例用 phase 错开
+    let angle = select(0.0, uView.time, animate) + instance.phase;
+    var point = centre + orbitRadius * instance.scale * vec2f(cos(angle), sin(angle));
+    let position = point + decodePosition(in.position) * instance.scale;
+
+    var out : VertexOutput; // 输入和输出都使用自定义结构
+    out.position = vec4f(position.x, position.y * uView.aspect, instance.depth, 1.0);
+    out.color = in.color * instance.tint.rgb; // 向片段着色器转发 颜色值
+    return out;
+}
+
+@fragment
+fn fs_main(in : VertexOutput) -> @location(0) vec4f {
+    return vec4f(in.color, 1.0);
+}
+
+#endif
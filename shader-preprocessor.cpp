@@ -0,0 +1,420 @@
+#include "shader-preprocessor.h"
+#include "webgpu-utils.h"
+
+#include <iostream>
+#include <fstream>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+std::string DirectoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string Trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool IsIdentifierStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool IsIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// "NAME rest" -> NAME, rest
+std::string TakeIdentifier(const std::string& text, std::string* rest = nullptr) {
+    size_t end = 0;
+    while (end < text.size() && IsIdentifierChar(text[end])) {
+        ++end;
+    }
+    if (rest != nullptr) {
+        *rest = Trim(text.substr(end));
+    }
+    return text.substr(0, end);
+}
+
+// #if 表达式的递归下降求值
+class ExpressionParser {
+public:
+    ExpressionParser(const std::string& text, const ShaderPreprocessor::Defines& defines, int depth)
+        : text(text), defines(defines), depth(depth) {
+    }
+
+    bool Evaluate(long long& value) {
+        value = ParseOr();
+        SkipSpaces();
+        return ok && position == text.size();
+    }
+
+private:
+    void SkipSpaces() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            ++position;
+        }
+    }
+
+    bool Accept(const char* op) {
+        SkipSpaces();
+        size_t length = std::char_traits<char>::length(op);
+        if (text.compare(position, length, op) == 0) {
+            position += length;
+            return true;
+        }
+        return false;
+    }
+
+    long long ParseOr() {
+        long long value = ParseAnd();
+        while (Accept("||")) {
+            long long right = ParseAnd();
+            value = (value != 0 || right != 0) ? 1 : 0;
+        }
+        return value;
+    }
+
+    long long ParseAnd() {
+        long long value = ParseEquality();
+        while (Accept("&&")) {
+            long long right = ParseEquality();
+            value = (value != 0 && right != 0) ? 1 : 0;
+        }
+        return value;
+    }
+
+    long long ParseEquality() {
+        long long value = ParseRelational();
+        while (true) {
+            if (Accept("==")) {
+                value = value == ParseRelational();
+            } else if (Accept("!=")) {
+                value = value != ParseRelational();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long ParseRelational() {
+        long long value = ParseAdditive();
+        while (true) {
+            if (Accept("<=")) {
+                value = value <= ParseAdditive();
+            } else if (Accept(">=")) {
+                value = value >= ParseAdditive();
+            } else if (Accept("<")) {
+                value = value < ParseAdditive();
+            } else if (Accept(">")) {
+                value = value > ParseAdditive();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long ParseAdditive() {
+        long long value = ParseUnary();
+        while (true) {
+            if (Accept("+")) {
+                value += ParseUnary();
+            } else if (Accept("-")) {
+                value -= ParseUnary();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    long long ParseUnary() {
+        if (Accept("!")) {
+            return ParseUnary() == 0 ? 1 : 0;
+        }
+        if (Accept("-")) {
+            return -ParseUnary();
+        }
+        return ParsePrimary();
+    }
+
+    long long ParsePrimary() {
+        SkipSpaces();
+        if (Accept("(")) {
+            long long value = ParseOr();
+            ok = ok && Accept(")");
+            return value;
+        }
+        if (position < text.size() && std::isdigit(static_cast<unsigned char>(text[position]))) {
+            size_t end = position;
+            while (end < text.size() && IsIdentifierChar(text[end])) {
+                ++end;
+            }
+            std::string number = text.substr(position, end - position);
+            position = end;
+            char* last = nullptr;
+            long long value = std::strtoll(number.c_str(), &last, 0);
+            ok = ok && *last == '\0';
+            return value;
+        }
+        if (position < text.size() && IsIdentifierStart(text[position])) {
+            std::string name = TakeIdentifier(text.substr(position));
+            position += name.size();
+            if (name == "defined") {
+                bool parenthesized = Accept("(");
+                SkipSpaces();
+                std::string target = TakeIdentifier(text.substr(position));
+                position += target.size();
+                ok = ok && !target.empty() && (!parenthesized || Accept(")"));
+                return defines.count(target) > 0 ? 1 : 0;
+            }
+            auto it = defines.find(name);
+            if (it == defines.end()) {
+                return 0;
+            }
+            if (depth > 8) {
+                ok = false; // 宏互相引用
+                return 0;
+            }
+            long long value = 0;
+            ok = ok && ExpressionParser(it->second, defines, depth + 1).Evaluate(value);
+            return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+private:
+    const std::string& text;
+    const ShaderPreprocessor::Defines& defines;
+    int depth;
+    size_t position = 0;
+    bool ok = true;
+};
+
+// 把行里出现的宏名替换成值；// 之后的注释原样保留
+std::string Substitute(const std::string& line, const ShaderPreprocessor::Defines& defines, int depth = 0) {
+    if (defines.empty() || depth > 8) {
+        return line;
+    }
+    std::string result;
+    result.reserve(line.size());
+    size_t i = 0;
+    while (i < line.size()) {
+        if (line.compare(i, 2, "//") == 0) {
+            result.append(line, i, std::string::npos);
+            break;
+        }
+        if (IsIdentifierStart(line[i]) && (i == 0 || !IsIdentifierChar(line[i - 1]))) {
+            std::string name = TakeIdentifier(line.substr(i));
+            auto it = defines.find(name);
+            result += it != defines.end() ? Substitute(it->second, defines, depth + 1) : name;
+            i += name.size();
+            continue;
+        }
+        result += line[i++];
+    }
+    return result;
+}
+
+} // namespace
+
+
+struct ShaderPreprocessor::Context {
+    Defines defines;
+    std::set<std::string> included;
+};
+
+
+ShaderPreprocessor::ShaderPreprocessor(std::string directory)
+    : directory(std::move(directory)) {
+    if (!this->directory.empty() && this->directory.back() != '/') {
+        this->directory += '/';
+    }
+}
+
+std::string ShaderPreprocessor::PermutationKey(const std::string& path, const Defines& defines) {
+    std::string key = path;
+    for (const auto& it : defines) {
+        key += ';';
+        key += it.first;
+        key += '=';
+        key += it.second;
+    }
+    return key;
+}
+
+bool ShaderPreprocessor::Process(const std::string& path, const Defines& defines, std::string& source) {
+    std::string key = PermutationKey(path, defines);
+    auto it = variants.find(key);
+    if (it != variants.end()) {
+        ++stats.hits;
+        source = it->second;
+        return true;
+    }
+
+    Context context;
+    context.defines = defines;
+    for (auto& define : context.defines) {
+        if (define.second.empty()) {
+            define.second = "1";
+        }
+    }
+    std::string output;
+    if (!Expand(directory + path, context, output)) {
+        return false;
+    }
+    ++stats.expansions;
+    if (sourceHashes.insert(hashFnv1a(output.data(), output.size())).second) {
+        ++stats.uniqueSources;
+    }
+    source = output;
+    variants.emplace(std::move(key), std::move(output));
+    return true;
+}
+
+void ShaderPreprocessor::Invalidate() {
+    files.clear();
+    variants.clear();
+}
+
+std::vector<std::string> ShaderPreprocessor::GetDependencies() const {
+    std::vector<std::string> result;
+    for (const auto& it : files) {
+        result.push_back(it.first);
+    }
+    return result;
+}
+
+const std::vector<std::string>* ShaderPreprocessor::LoadLines(const std::string& path) {
+    auto it = files.find(path);
+    if (it != files.end()) {
+        return &it->second;
+    }
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return &files.emplace(path, std::move(lines)).first->second;
+}
+
+bool ShaderPreprocessor::Expand(const std::string& path, Context& context, std::string& output) {
+    if (!context.included.insert(path).second) {
+        return true;
+    }
+    const std::vector<std::string>* lines = LoadLines(path);
+    if (lines == nullptr) {
+        std::cout << "ShaderPreprocessor: could not open " << path << std::endl;
+        return false;
+    }
+
+    struct Branch {
+        bool parentActive;
+        bool active;    // 当前分支是否输出
+        bool taken;     // 之前的分支里已经有一个成立
+        bool sawElse;
+    };
+    std::vector<Branch> branches;
+    auto active = [&branches]() { return branches.empty() || branches.back().active; };
+    auto fail = [&path](size_t line, const std::string& message) {
+        std::cout << "ShaderPreprocessor: " << path << ":" << line + 1 << ": " << message << std::endl;
+        return false;
+    };
+    auto evaluate = [&context](const std::string& expression, bool& value) {
+        long long result = 0;
+        if (!ExpressionParser(expression, context.defines, 0).Evaluate(result)) {
+            return false;
+        }
+        value = result != 0;
+        return true;
+    };
+
+    for (size_t n = 0; n < lines->size(); ++n) {
+        const std::string& line = (*lines)[n];
+        std::string trimmed = Trim(line);
+        if (trimmed.empty() || trimmed[0] != '#') {
+            if (active()) {
+                output += Substitute(line, context.defines);
+                output += '\n';
+            }
+            continue;
+        }
+
+        std::string argument;
+        std::string directive = TakeIdentifier(Trim(trimmed.substr(1)), &argument);
+        if (directive == "if" || directive == "ifdef" || directive == "ifndef") {
+            bool condition = false;
+            if (active()) {
+                if (directive == "if") {
+                    if (!evaluate(argument, condition)) {
+                        return fail(n, "invalid expression '" + argument + "'");
+                    }
+                } else {
+                    condition = context.defines.count(TakeIdentifier(argument)) > 0;
+                    condition = directive == "ifdef" ? condition : !condition;
+                }
+            }
+            bool parentActive = active();
+            branches.push_back({ parentActive, parentActive && condition, condition, false });
+        } else if (directive == "elif") {
+            if (branches.empty() || branches.back().sawElse) {
+                return fail(n, "unexpected #elif");
+            }
+            Branch& branch = branches.back();
+            bool condition = false;
+            if (branch.parentActive && !branch.taken && !evaluate(argument, condition)) {
+                return fail(n, "invalid expression '" + argument + "'");
+            }
+            branch.active = branch.parentActive && !branch.taken && condition;
+            branch.taken = branch.taken || condition;
+        } else if (directive == "else") {
+            if (branches.empty() || branches.back().sawElse) {
+                return fail(n, "unexpected #else");
+            }
+            Branch& branch = branches.back();
+            branch.active = branch.parentActive && !branch.taken;
+            branch.taken = true;
+            branch.sawElse = true;
+        } else if (directive == "endif") {
+            if (branches.empty()) {
+                return fail(n, "unexpected #endif");
+            }
+            branches.pop_back();
+        } else if (!active()) {
+            continue; // 未选中分支里的其它指令不处理
+        } else if (directive == "define") {
+            std::string value;
+            std::string name = TakeIdentifier(argument, &value);
+            if (name.empty()) {
+                return fail(n, "#define without a name");
+            }
+            context.defines[name] = value.empty() ? "1" : value;
+        } else if (directive == "undef") {
+            context.defines.erase(TakeIdentifier(argument));
+        } else if (directive == "include") {
+            if (argument.size() < 2 || argument.front() != '"' || argument.back() != '"') {
+                return fail(n, "expected #include \"file\"");
+            }
+            std::string includePath = DirectoryOf(path) + argument.substr(1, argument.size() - 2);
+            if (!Expand(includePath, context, output)) {
+                return fail(n, "included from here");
+            }
+        } else {
+            return fail(n, "unknown directive #" + directive);
+        }
+    }
+    if (!branches.empty()) {
+        return fail(lines->size() - 1, "missing #endif");
+    }
+    return true;
+}
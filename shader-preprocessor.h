@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// WGSL 没有预处理器，这里补一个够用的子集，用来从一份源码生成多个特性变体（permutation）：
+//   #include "file"            相对当前文件所在目录；每个文件在一次展开中只包含一次（WGSL 不允许重复声明）
+//   #define NAME [value] / #undef NAME  （不带值时为 1）
+//   #if expr / #ifdef / #ifndef / #elif / #else / #endif
+// expr 支持整数、defined(NAME)、! && || == != < <= > >= + - 和括号；未定义的名字按 0 处理。
+// 普通行里的 NAME 会被替换成它的值（只有对象式宏，没有带参数的宏）。
+// 同一 (文件, defines) 只展开一次；展开结果按内容哈希统计，交给 PipelineCache::GetShaderModule 后相同的源码只编译一次。
+class ShaderPreprocessor {
+public:
+    using Defines = std::map<std::string, std::string>;    // 有序：同一组 defines 总得到同一个 permutation key
+
+    struct Stats {
+        uint32_t expansions = 0;    // 实际展开的变体数
+        uint32_t hits = 0;          // 同一 permutation 重复请求
+        uint32_t uniqueSources = 0; // 展开结果去重后的份数
+    };
+
+    explicit ShaderPreprocessor(std::string directory);
+
+    // path 相对 directory；出错时打印 文件:行号 并返回 false
+    bool Process(const std::string& path, const Defines& defines, std::string& source);
+    // 丢弃缓存的文件内容与展开结果（磁盘上的文件改了之后）
+    void Invalidate();
+
+    // 目前为止读到过的所有文件（含 include），热重载时都要监视
+    std::vector<std::string> GetDependencies() const;
+    const Stats& GetStats() const { return stats; }
+
+    static std::string PermutationKey(const std::string& path, const Defines& defines);
+
+private:
+    struct Context;
+    const std::vector<std::string>* LoadLines(const std::string& path);
+    bool Expand(const std::string& path, Context& context, std::string& output);
+
+private:
+    std::string directory;
+    std::unordered_map<std::string, std::vector<std::string>> files;   // 路径 -> 行
+    std::unordered_map<std::string, std::string> variants;             // permutation key -> 展开结果
+    std::set<uint64_t> sourceHashes;
+    Stats stats;
+};
@@ -0,0 +1,782 @@
+#include "shader-reflection.h"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <set>
+
+namespace {
+
+struct Token {
+    enum Kind { Identifier, Number, Symbol, End };
+    Kind kind = End;
+    std::string text;
+    int line = 0;
+};
+
+std::vector<Token> Tokenize(const std::string& source) {
+    std::vector<Token> tokens;
+    int line = 1;
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == '\n') {
+            ++line;
+            ++i;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (source.compare(i, 2, "//") == 0) {
+            while (i < source.size() && source[i] != '\n') {
+                ++i;
+            }
+        } else if (source.compare(i, 2, "/*") == 0) {
+            // WGSL 的块注释可以嵌套
+            int depth = 0;
+            do {
+                if (source.compare(i, 2, "/*") == 0) {
+                    ++depth;
+                    i += 2;
+                } else if (source.compare(i, 2, "*/") == 0) {
+                    --depth;
+                    i += 2;
+                } else {
+                    line += source[i] == '\n' ? 1 : 0;
+                    ++i;
+                }
+            } while (depth > 0 && i < source.size());
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t end = i;
+            while (end < source.size() && (std::isalnum(static_cast<unsigned char>(source[end])) || source[end] == '_')) {
+                ++end;
+            }
+            tokens.push_back({ Token::Identifier, source.substr(i, end - i), line });
+            i = end;
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            size_t end = i;
+            while (end < source.size() && (std::isalnum(static_cast<unsigned char>(source[end])) || source[end] == '.' || source[end] == '_')) {
+                ++end;
+            }
+            tokens.push_back({ Token::Number, source.substr(i, end - i), line });
+            i = end;
+        } else if (source.compare(i, 2, "->") == 0) {
+            tokens.push_back({ Token::Symbol, "->", line });
+            i += 2;
+        } else {
+            // '>' 总是单独成词，array<vec2<f32>> 才能正常收尾
+            tokens.push_back({ Token::Symbol, std::string(1, c), line });
+            ++i;
+        }
+    }
+    tokens.push_back({ Token::End, "", line });
+    return tokens;
+}
+
+uint64_t RoundUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 顶点格式的字节数与分量的标量类型（f32 / u32 / i32）
+bool DescribeVertexFormat(wgpu::VertexFormat format, uint64_t& size, std::string& scalar, uint32_t& components) {
+    struct Info { WGPUVertexFormat format; uint64_t size; const char* scalar; uint32_t components; };
+    static const Info infos[] = {
+        { wgpu::VertexFormat::Uint8x2, 2, "u32", 2 },   { wgpu::VertexFormat::Uint8x4, 4, "u32", 4 },
+        { wgpu::VertexFormat::Sint8x2, 2, "i32", 2 },   { wgpu::VertexFormat::Sint8x4, 4, "i32", 4 },
+        { wgpu::VertexFormat::Unorm8x2, 2, "f32", 2 },  { wgpu::VertexFormat::Unorm8x4, 4, "f32", 4 },
+        { wgpu::VertexFormat::Snorm8x2, 2, "f32", 2 },  { wgpu::VertexFormat::Snorm8x4, 4, "f32", 4 },
+        { wgpu::VertexFormat::Uint16x2, 4, "u32", 2 },  { wgpu::VertexFormat::Uint16x4, 8, "u32", 4 },
+        { wgpu::VertexFormat::Sint16x2, 4, "i32", 2 },  { wgpu::VertexFormat::Sint16x4, 8, "i32", 4 },
+        { wgpu::VertexFormat::Unorm16x2, 4, "f32", 2 }, { wgpu::VertexFormat::Unorm16x4, 8, "f32", 4 },
+        { wgpu::VertexFormat::Snorm16x2, 4, "f32", 2 }, { wgpu::VertexFormat::Snorm16x4, 8, "f32", 4 },
+        { wgpu::VertexFormat::Float16x2, 4, "f32", 2 }, { wgpu::VertexFormat::Float16x4, 8, "f32", 4 },
+        { wgpu::VertexFormat::Float32, 4, "f32", 1 },   { wgpu::VertexFormat::Float32x2, 8, "f32", 2 },
+        { wgpu::VertexFormat::Float32x3, 12, "f32", 3 },{ wgpu::VertexFormat::Float32x4, 16, "f32", 4 },
+        { wgpu::VertexFormat::Uint32, 4, "u32", 1 },    { wgpu::VertexFormat::Uint32x2, 8, "u32", 2 },
+        { wgpu::VertexFormat::Uint32x3, 12, "u32", 3 }, { wgpu::VertexFormat::Uint32x4, 16, "u32", 4 },
+        { wgpu::VertexFormat::Sint32, 4, "i32", 1 },    { wgpu::VertexFormat::Sint32x2, 8, "i32", 2 },
+        { wgpu::VertexFormat::Sint32x3, 12, "i32", 3 }, { wgpu::VertexFormat::Sint32x4, 16, "i32", 4 },
+    };
+    for (const Info& info : infos) {
+        if (info.format == format) {
+            size = info.size;
+            scalar = info.scalar;
+            components = info.components;
+            return true;
+        }
+    }
+    return false;
+}
+
+// WGSL 类型对应的 32 位顶点格式
+wgpu::VertexFormat DefaultVertexFormat(const std::string& scalar, uint32_t components) {
+    static const WGPUVertexFormat f32[] = { wgpu::VertexFormat::Float32, wgpu::VertexFormat::Float32x2, wgpu::VertexFormat::Float32x3, wgpu::VertexFormat::Float32x4 };
+    static const WGPUVertexFormat u32[] = { wgpu::VertexFormat::Uint32, wgpu::VertexFormat::Uint32x2, wgpu::VertexFormat::Uint32x3, wgpu::VertexFormat::Uint32x4 };
+    static const WGPUVertexFormat i32[] = { wgpu::VertexFormat::Sint32, wgpu::VertexFormat::Sint32x2, wgpu::VertexFormat::Sint32x3, wgpu::VertexFormat::Sint32x4 };
+    if (components < 1 || components > 4) {
+        return wgpu::VertexFormat::Undefined;
+    }
+    if (scalar == "f32" || scalar == "f16") {
+        return f32[components - 1];
+    }
+    if (scalar == "u32") {
+        return u32[components - 1];
+    }
+    if (scalar == "i32") {
+        return i32[components - 1];
+    }
+    return wgpu::VertexFormat::Undefined;
+}
+
+const char* CppScalar(const std::string& scalar, uint64_t bytes) {
+    if (scalar == "f32") {
+        return bytes == 4 ? "float" : bytes == 2 ? "uint16_t" : "uint8_t"; // 归一化/半精度格式按原始整数存
+    }
+    if (scalar == "u32") {
+        return bytes == 4 ? "uint32_t" : bytes == 2 ? "uint16_t" : "uint8_t";
+    }
+    return bytes == 4 ? "int32_t" : bytes == 2 ? "int16_t" : "int8_t";
+}
+
+wgpu::TextureFormat StorageTextureFormat(const std::string& name) {
+    static const std::pair<const char*, WGPUTextureFormat> formats[] = {
+        { "rgba8unorm", wgpu::TextureFormat::RGBA8Unorm }, { "bgra8unorm", wgpu::TextureFormat::BGRA8Unorm },
+        { "rgba16float", wgpu::TextureFormat::RGBA16Float }, { "rgba32float", wgpu::TextureFormat::RGBA32Float },
+        { "r32float", wgpu::TextureFormat::R32Float }, { "r32uint", wgpu::TextureFormat::R32Uint },
+        { "r32sint", wgpu::TextureFormat::R32Sint }, { "rg32float", wgpu::TextureFormat::RG32Float },
+    };
+    for (const auto& format : formats) {
+        if (name == format.first) {
+            return format.second;
+        }
+    }
+    return wgpu::TextureFormat::Undefined;
+}
+
+wgpu::TextureViewDimension TextureDimension(const std::string& name) {
+    if (name.find("_2d_array") != std::string::npos) {
+        return wgpu::TextureViewDimension::_2DArray;
+    }
+    if (name.find("_cube_array") != std::string::npos) {
+        return wgpu::TextureViewDimension::CubeArray;
+    }
+    if (name.find("_cube") != std::string::npos) {
+        return wgpu::TextureViewDimension::Cube;
+    }
+    if (name.find("_3d") != std::string::npos) {
+        return wgpu::TextureViewDimension::_3D;
+    }
+    if (name.find("_1d") != std::string::npos) {
+        return wgpu::TextureViewDimension::_1D;
+    }
+    return wgpu::TextureViewDimension::_2D;
+}
+
+} // namespace
+
+
+std::string ShaderReflection::Type::ToString() const {
+    std::string text = name;
+    if (!args.empty()) {
+        text += '<';
+        for (size_t i = 0; i < args.size(); ++i) {
+            text += (i > 0 ? ", " : "") + args[i].ToString();
+        }
+        text += '>';
+    }
+    return text;
+}
+
+
+// 递归下降，只认得模块作用域的声明
+class ShaderReflection::Parser {
+public:
+    struct Function {
+        std::string name;
+        wgpu::ShaderStage stage = wgpu::ShaderStage::None;
+        std::vector<Member> params;
+        std::set<std::string> identifiers;  // 函数体里出现的名字
+    };
+
+    Parser(ShaderReflection& reflection, const std::string& source)
+        : reflection(reflection), tokens(Tokenize(source)) {
+    }
+
+    bool Run() {
+        while (ok && Peek().kind != Token::End) {
+            ParseDeclaration();
+        }
+        if (!ok) {
+            std::cout << "ShaderReflection: line " << errorLine << ": " << error << std::endl;
+            return false;
+        }
+        Finish();
+        return true;
+    }
+
+private:
+    const Token& Peek() const { return tokens[position]; }
+
+    Token Next() {
+        const Token& token = tokens[position];
+        if (token.kind != Token::End) {
+            ++position;
+        }
+        return token;
+    }
+
+    bool Accept(const char* text) {
+        if (Peek().kind != Token::End && Peek().text == text) {
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    bool Expect(const char* text) {
+        if (!Accept(text)) {
+            Fail(std::string("expected '") + text + "' but got '" + Peek().text + "'");
+        }
+        return ok;
+    }
+
+    std::string ExpectIdentifier() {
+        if (Peek().kind != Token::Identifier) {
+            Fail("expected an identifier but got '" + Peek().text + "'");
+            return std::string();
+        }
+        return Next().text;
+    }
+
+    void Fail(const std::string& message) {
+        if (ok) {
+            ok = false;
+            error = message;
+            errorLine = Peek().line;
+        }
+    }
+
+    // @name 或 @name(a, b)；参数按原文拼回去
+    std::map<std::string, std::string> ParseAttributes() {
+        std::map<std::string, std::string> attributes;
+        while (ok && Accept("@")) {
+            std::string name = ExpectIdentifier();
+            std::string value;
+            if (Accept("(")) {
+                int depth = 1;
+                while (ok && depth > 0) {
+                    const Token& token = Peek();
+                    if (token.kind == Token::End) {
+                        Fail("unterminated attribute");
+                        break;
+                    }
+                    depth += token.text == "(" ? 1 : token.text == ")" ? -1 : 0;
+                    if (depth > 0) {
+                        value += token.text;
+                    }
+                    Next();
+                }
+            }
+            attributes[name] = value;
+        }
+        return attributes;
+    }
+
+    Type ParseType() {
+        Type type;
+        if (Peek().kind == Token::Number) {
+            type.name = Next().text;
+            return type;
+        }
+        type.name = ExpectIdentifier();
+        if (Accept("<")) {
+            do {
+                type.args.push_back(ParseType());
+            } while (ok && Accept(","));
+            Expect(">");
+        }
+        return type;
+    }
+
+    // 跳到本层的 ';'（初始化表达式里可能有括号）
+    void SkipStatement() {
+        int depth = 0;
+        while (ok && Peek().kind != Token::End) {
+            const std::string& text = Next().text;
+            if (text == "(" || text == "{" || text == "[") {
+                ++depth;
+            } else if (text == ")" || text == "}" || text == "]") {
+                --depth;
+            } else if (text == ";" && depth <= 0) {
+                return;
+            }
+        }
+    }
+
+    void ParseDeclaration() {
+        std::map<std::string, std::string> attributes = ParseAttributes();
+        if (Accept("struct")) {
+            ParseStruct();
+        } else if (Accept("var")) {
+            ParseVariable(attributes);
+        } else if (Accept("fn")) {
+            ParseFunction(attributes);
+        } else if (Accept("alias")) {
+            std::string name = ExpectIdentifier();
+            Expect("=");
+            reflection.aliases[name] = ParseType();
+            Expect(";");
+        } else if (Accept(";")) {
+            // 空语句
+        } else if (Peek().kind == Token::Identifier) {
+            // override / const / enable / requires / diagnostic / const_assert ...：与布局无关
+            SkipStatement();
+        } else {
+            Fail("unexpected '" + Peek().text + "'");
+        }
+    }
+
+    void ParseStruct() {
+        std::string name = ExpectIdentifier();
+        Expect("{");
+        std::vector<Member> members;
+        while (ok && !Accept("}")) {
+            Member member;
+            member.attributes = ParseAttributes();
+            member.name = ExpectIdentifier();
+            Expect(":");
+            member.type = ParseType();
+            members.push_back(member);
+            if (!Accept(",") && Peek().text != "}") {
+                Fail("expected ',' or '}' in struct " + name);
+            }
+        }
+        Accept(";");
+        reflection.structs[name] = members;
+    }
+
+    void ParseVariable(const std::map<std::string, std::string>& attributes) {
+        std::string addressSpace;
+        std::string access;
+        if (Accept("<")) {
+            addressSpace = ExpectIdentifier();
+            if (Accept(",")) {
+                access = ExpectIdentifier();
+            }
+            Expect(">");
+        }
+        std::string name = ExpectIdentifier();
+        Type type;
+        if (Accept(":")) {
+            type = ParseType();
+        }
+        SkipStatement();
+        if (!ok || attributes.count("group") == 0 || attributes.count("binding") == 0) {
+            return; // private / workgroup 变量
+        }
+
+        Binding binding;
+        binding.group = static_cast<uint32_t>(std::stoul(attributes.at("group")));
+        binding.binding = static_cast<uint32_t>(std::stoul(attributes.at("binding")));
+        binding.name = name;
+        binding.type = type;
+        const std::string& typeName = type.name;
+        if (addressSpace == "uniform") {
+            binding.kind = BindingKind::UniformBuffer;
+        } else if (addressSpace == "storage") {
+            binding.kind = access == "read_write" ? BindingKind::StorageBuffer : BindingKind::ReadOnlyStorageBuffer;
+        } else if (typeName == "sampler") {
+            binding.kind = BindingKind::Sampler;
+        } else if (typeName == "sampler_comparison") {
+            binding.kind = BindingKind::ComparisonSampler;
+        } else if (typeName.rfind("texture_storage_", 0) == 0) {
+            binding.kind = BindingKind::StorageTexture;
+        } else if (typeName.rfind("texture_depth_", 0) == 0) {
+            binding.kind = BindingKind::DepthTexture;
+        } else if (typeName.rfind("texture_", 0) == 0) {
+            binding.kind = BindingKind::Texture;
+        } else {
+            Fail("unsupported binding type '" + type.ToString() + "' for " + name);
+            return;
+        }
+        bindings.push_back(binding);
+    }
+
+    void ParseFunction(const std::map<std::string, std::string>& attributes) {
+        Function function;
+        function.name = ExpectIdentifier();
+        if (attributes.count("vertex") > 0) {
+            function.stage = wgpu::ShaderStage::Vertex;
+        } else if (attributes.count("fragment") > 0) {
+            function.stage = wgpu::ShaderStage::Fragment;
+        } else if (attributes.count("compute") > 0) {
+            function.stage = wgpu::ShaderStage::Compute;
+        }
+        Expect("(");
+        while (ok && !Accept(")")) {
+            Member param;
+            param.attributes = ParseAttributes();
+            param.name = ExpectIdentifier();
+            Expect(":");
+            param.type = ParseType();
+            function.params.push_back(param);
+            if (!Accept(",") && Peek().text != ")") {
+                Fail("expected ',' or ')' in fn " + function.name);
+            }
+        }
+        if (Accept("->")) {
+            ParseAttributes();
+            ParseType();
+        }
+        Expect("{");
+        int depth = 1;
+        while (ok && depth > 0) {
+            const Token& token = Peek();
+            if (token.kind == Token::End) {
+                Fail("unterminated fn " + function.name);
+                break;
+            }
+            if (token.kind == Token::Identifier) {
+                function.identifiers.insert(token.text);
+            }
+            depth += token.text == "{" ? 1 : token.text == "}" ? -1 : 0;
+            Next();
+        }
+        functions.push_back(function);
+    }
+
+    // 入口 -> 它（经由调用的函数）用到的名字
+    void CollectIdentifiers(const Function& function, std::set<std::string>& visited, std::set<std::string>& identifiers) const {
+        if (!visited.insert(function.name).second) {
+            return;
+        }
+        for (const std::string& identifier : function.identifiers) {
+            identifiers.insert(identifier);
+            for (const Function& callee : functions) {
+                if (callee.name == identifier) {
+                    CollectIdentifiers(callee, visited, identifiers);
+                }
+            }
+        }
+    }
+
+    void Finish() {
+        for (const Function& function : functions) {
+            if (function.stage == wgpu::ShaderStage::None) {
+                continue;
+            }
+            EntryPoint entry;
+            entry.name = function.name;
+            entry.stage = function.stage;
+            if (function.stage == wgpu::ShaderStage::Vertex) {
+                for (const Member& param : function.params) {
+                    VertexInput input;
+                    input.name = param.name;
+                    auto members = reflection.structs.find(reflection.Resolve(param.type).name);
+                    if (members != reflection.structs.end()) {
+                        input.structName = members->first;
+                        for (const Member& member : members->second) {
+                            if (member.attributes.count("location") > 0) {
+                                input.attributes.push_back({ member.name, static_cast<uint32_t>(std::stoul(member.attributes.at("location"))), member.type });
+                            }
+                        }
+                    } else if (param.attributes.count("location") > 0) {
+                        input.attributes.push_back({ param.name, static_cast<uint32_t>(std::stoul(param.attributes.at("location"))), param.type });
+                    }
+                    if (!input.attributes.empty()) {
+                        entry.inputs.push_back(input);
+                    }
+                }
+            }
+            reflection.entryPoints.push_back(entry);
+
+            std::set<std::string> visited;
+            std::set<std::string> identifiers;
+            CollectIdentifiers(function, visited, identifiers);
+            for (Binding& binding : bindings) {
+                if (identifiers.count(binding.name) > 0) {
+                    binding.visibility |= static_cast<uint32_t>(function.stage);
+                }
+            }
+        }
+        for (Binding& binding : bindings) {
+            if (binding.kind == BindingKind::UniformBuffer || binding.kind == BindingKind::StorageBuffer
+                || binding.kind == BindingKind::ReadOnlyStorageBuffer) {
+                uint64_t align = 0;
+                reflection.GetLayout(binding.type, align, binding.size);
+            }
+        }
+        std::sort(bindings.begin(), bindings.end(), [](const Binding& a, const Binding& b) {
+            return a.group != b.group ? a.group < b.group : a.binding < b.binding;
+        });
+        reflection.bindings = bindings;
+    }
+
+private:
+    ShaderReflection& reflection;
+    std::vector<Token> tokens;
+    size_t position = 0;
+    bool ok = true;
+    std::string error;
+    int errorLine = 0;
+    std::vector<Function> functions;
+    std::vector<Binding> bindings;
+};
+
+
+bool ShaderReflection::Parse(const std::string& source) {
+    structs.clear();
+    aliases.clear();
+    entryPoints.clear();
+    bindings.clear();
+    return Parser(*this, source).Run();
+}
+
+const ShaderReflection::EntryPoint* ShaderReflection::FindEntryPoint(const std::string& name) const {
+    for (const EntryPoint& entry : entryPoints) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+ShaderReflection::Type ShaderReflection::Resolve(const Type& type) const {
+    auto alias = aliases.find(type.name);
+    if (alias != aliases.end()) {
+        return Resolve(alias->second);
+    }
+    // vec3f -> vec3<f32>，mat4x4f -> mat4x4<f32>
+    const std::string& name = type.name;
+    bool vector = name.size() == 5 && name.compare(0, 3, "vec") == 0;
+    bool matrix = name.size() == 7 && name.compare(0, 3, "mat") == 0;
+    if ((vector || matrix) && type.args.empty()) {
+        static const std::map<char, const char*> scalars = { { 'f', "f32" }, { 'h', "f16" }, { 'i', "i32" }, { 'u', "u32" } };
+        auto scalar = scalars.find(name.back());
+        if (scalar != scalars.end()) {
+            Type expanded;
+            expanded.name = name.substr(0, name.size() - 1);
+            expanded.args.push_back({ scalar->second, {} });
+            return expanded;
+        }
+    }
+    Type resolved = type;
+    for (Type& arg : resolved.args) {
+        arg = Resolve(arg);
+    }
+    return resolved;
+}
+
+bool ShaderReflection::GetLayout(const Type& original, uint64_t& align, uint64_t& size) const {
+    Type type = Resolve(original);
+    const std::string& name = type.name;
+    if (name == "f32" || name == "i32" || name == "u32" || name == "bool") {
+        align = size = 4;
+        return true;
+    }
+    if (name == "f16") {
+        align = size = 2;
+        return true;
+    }
+    if (name == "atomic" && type.args.size() == 1) {
+        return GetLayout(type.args[0], align, size);
+    }
+    if (name.size() == 4 && name.compare(0, 3, "vec") == 0 && type.args.size() == 1) {
+        uint64_t scalarAlign = 0;
+        uint64_t scalarSize = 0;
+        if (!GetLayout(type.args[0], scalarAlign, scalarSize)) {
+            return false;
+        }
+        uint64_t count = static_cast<uint64_t>(name[3] - '0');
+        size = scalarSize * count;
+        align = scalarSize * (count == 3 ? 4 : count);
+        return true;
+    }
+    if (name.size() == 6 && name.compare(0, 3, "mat") == 0 && type.args.size() == 1) {
+        // matCxR 按 C 个 vecR 列排列
+        Type column;
+        column.name = std::string("vec") + name[5];
+        column.args = type.args;
+        uint64_t columnSize = 0;
+        if (!GetLayout(column, align, columnSize)) {
+            return false;
+        }
+        size = static_cast<uint64_t>(name[3] - '0') * RoundUp(columnSize, align);
+        return true;
+    }
+    if (name == "array" && !type.args.empty()) {
+        uint64_t elementSize = 0;
+        if (!GetLayout(type.args[0], align, elementSize)) {
+            return false;
+        }
+        uint64_t count = type.args.size() > 1 ? std::stoull(type.args[1].name) : 1; // 运行时数组按 1 个元素计
+        size = count * RoundUp(elementSize, align);
+        return true;
+    }
+    auto members = structs.find(name);
+    if (members != structs.end()) {
+        uint64_t offset = 0;
+        align = 1;
+        for (const Member& member : members->second) {
+            uint64_t memberAlign = 0;
+            uint64_t memberSize = 0;
+            if (!GetLayout(member.type, memberAlign, memberSize)) {
+                return false;
+            }
+            auto it = member.attributes.find("align");
+            if (it != member.attributes.end()) {
+                memberAlign = std::stoull(it->second);
+            }
+            it = member.attributes.find("size");
+            if (it != member.attributes.end()) {
+                memberSize = std::stoull(it->second);
+            }
+            offset = RoundUp(offset, memberAlign) + memberSize;
+            align = std::max(align, memberAlign);
+        }
+        size = RoundUp(offset, align);
+        return true;
+    }
+    return false;
+}
+
+std::vector<wgpu::BindGroupLayoutEntry> ShaderReflection::GetBindGroupLayoutEntries(uint32_t group) const {
+    std::vector<wgpu::BindGroupLayoutEntry> entries;
+    for (const Binding& binding : bindings) {
+        if (binding.group != group) {
+            continue;
+        }
+        wgpu::BindGroupLayoutEntry entry = wgpu::Default;
+        entry.binding = binding.binding;
+        entry.visibility = binding.visibility;
+        switch (binding.kind) {
+        case BindingKind::UniformBuffer:
+            entry.buffer.type = wgpu::BufferBindingType::Uniform;
+            entry.buffer.minBindingSize = binding.size;
+            break;
+        case BindingKind::StorageBuffer:
+            entry.buffer.type = wgpu::BufferBindingType::Storage;
+            entry.buffer.minBindingSize = binding.size;
+            break;
+        case BindingKind::ReadOnlyStorageBuffer:
+            entry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+            entry.buffer.minBindingSize = binding.size;
+            break;
+        case BindingKind::Sampler:
+            entry.sampler.type = wgpu::SamplerBindingType::Filtering;
+            break;
+        case BindingKind::ComparisonSampler:
+            entry.sampler.type = wgpu::SamplerBindingType::Comparison;
+            break;
+        case BindingKind::Texture: {
+            const std::string scalar = binding.type.args.empty() ? "f32" : binding.type.args[0].name;
+            entry.texture.sampleType = scalar == "u32" ? wgpu::TextureSampleType::Uint
+                                     : scalar == "i32" ? wgpu::TextureSampleType::Sint : wgpu::TextureSampleType::Float;
+            entry.texture.viewDimension = TextureDimension(binding.type.name);
+            entry.texture.multisampled = binding.type.name.find("multisampled") != std::string::npos;
+            break;
+        }
+        case BindingKind::DepthTexture:
+            entry.texture.sampleType = wgpu::TextureSampleType::Depth;
+            entry.texture.viewDimension = TextureDimension(binding.type.name);
+            entry.texture.multisampled = binding.type.name.find("multisampled") != std::string::npos;
+            break;
+        case BindingKind::StorageTexture: {
+            const std::string access = binding.type.args.size() > 1 ? binding.type.args[1].name : "write";
+            entry.storageTexture.format = StorageTextureFormat(binding.type.args.empty() ? std::string() : binding.type.args[0].name);
+            entry.storageTexture.access = access == "read" ? wgpu::StorageTextureAccess::ReadOnly
+                                        : access == "read_write" ? wgpu::StorageTextureAccess::ReadWrite : wgpu::StorageTextureAccess::WriteOnly;
+            entry.storageTexture.viewDimension = TextureDimension(binding.type.name);
+            break;
+        }
+        }
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+bool ShaderReflection::PackVertexInput(const VertexInput& input, wgpu::VertexStepMode stepMode, PackedVertexLayout& layout,
+                                       const std::map<uint32_t, wgpu::VertexFormat>& formats) const {
+    layout = PackedVertexLayout();
+    layout.name = input.structName.empty() ? input.name : input.structName;
+    layout.stepMode = stepMode;
+    uint64_t offset = 0;
+    for (const VertexAttribute& attribute : input.attributes) {
+        Type type = Resolve(attribute.type);
+        bool vector = type.name.size() == 4 && type.name.compare(0, 3, "vec") == 0 && type.args.size() == 1;
+        std::string scalar = vector ? type.args[0].name : type.name;
+        uint32_t components = vector ? static_cast<uint32_t>(type.name[3] - '0') : 1;
+
+        PackedVertexLayout::Field field;
+        field.name = attribute.name;
+        field.location = attribute.location;
+        auto it = formats.find(attribute.location);
+        field.format = it != formats.end() ? it->second : DefaultVertexFormat(scalar, components);
+
+        std::string formatScalar;
+        uint32_t formatComponents = 0;
+        if (!DescribeVertexFormat(field.format, field.size, formatScalar, formatComponents)
+            || formatScalar != (scalar == "f16" ? "f32" : scalar)) {
+            std::cout << "ShaderReflection: vertex format of @location(" << attribute.location << ") "
+                      << attribute.name << " does not match " << type.ToString() << std::endl;
+            return false;
+        }
+        // 格式分量比 shader 多或少都可以（多的丢弃，少的补 0/1），只要求标量类型一致
+        field.offset = RoundUp(offset, std::min<uint64_t>(4, field.size));
+        offset = field.offset + field.size;
+        layout.fields.push_back(field);
+
+        wgpu::VertexAttribute vertexAttribute;
+        vertexAttribute.shaderLocation = field.location;
+        vertexAttribute.format = field.format;
+        vertexAttribute.offset = field.offset;
+        layout.attributes.push_back(vertexAttribute);
+    }
+    layout.stride = RoundUp(offset, 4);
+    return true;
+}
+
+wgpu::VertexBufferLayout ShaderReflection::PackedVertexLayout::GetLayout() const {
+    wgpu::VertexBufferLayout bufferLayout;
+    bufferLayout.attributeCount = attributes.size();
+    bufferLayout.attributes = attributes.data();
+    bufferLayout.arrayStride = stride;
+    bufferLayout.stepMode = stepMode;
+    return bufferLayout;
+}
+
+int64_t ShaderReflection::PackedVertexLayout::OffsetOf(const std::string& fieldName) const {
+    for (const Field& field : fields) {
+        if (field.name == fieldName) {
+            return static_cast<int64_t>(field.offset);
+        }
+    }
+    return -1;
+}
+
+std::string ShaderReflection::PackedVertexLayout::Describe() const {
+    std::ostringstream text;
+    text << "struct " << name << " { // stride " << stride << "\n";
+    uint64_t offset = 0;
+    uint32_t padding = 0;
+    for (const Field& field : fields) {
+        if (field.offset > offset) {
+            text << "    uint8_t _pad" << padding++ << "[" << field.offset - offset << "];\n";
+        }
+        uint64_t size = 0;
+        std::string scalar;
+        uint32_t components = 0;
+        DescribeVertexFormat(field.format, size, scalar, components);
+        uint64_t componentSize = size / components;
+        text << "    " << CppScalar(scalar, componentSize) << " " << field.name;
+        if (components > 1) {
+            text << "[" << components << "]";
+        }
+        text << "; // @location(" << field.location << ") offset " << field.offset << "\n";
+        offset = field.offset + field.size;
+    }
+    if (stride > offset) {
+        text << "    uint8_t _pad" << padding << "[" << stride - offset << "];\n";
+    }
+    text << "};";
+    return text.str();
+}
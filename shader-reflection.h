@@ -0,0 +1,105 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// WGSL 反射：从（预处理之后的）源码里解析出入口函数的顶点输入和 @group/@binding 声明，
+// 再据此生成 VertexBufferLayout 与 BindGroupLayoutEntry，不用在 C++ 里手抄一遍 shader 的布局。
+// 只解析声明（struct / var / fn 的签名与调用关系 / alias），函数体只扫描用到的名字，用来推算每个 binding 的 visibility。
+class ShaderReflection {
+public:
+    struct Type {
+        std::string name;           // f32、vec2、array、某个 struct 名 ...；数组长度也按 Type 存，name 为数字
+        std::vector<Type> args;     // 模板参数
+        std::string ToString() const;
+    };
+
+    struct VertexAttribute {
+        std::string name;
+        uint32_t location = 0;
+        Type type;
+    };
+
+    // 顶点入口的一个参数：struct 参数展开成它的各个 @location 成员，通常对应一个顶点 buffer
+    struct VertexInput {
+        std::string name;
+        std::string structName;     // 直接写 @location 的参数为空
+        std::vector<VertexAttribute> attributes;
+    };
+
+    struct EntryPoint {
+        std::string name;
+        wgpu::ShaderStage stage = wgpu::ShaderStage::None;
+        std::vector<VertexInput> inputs;    // 仅顶点入口
+    };
+
+    enum class BindingKind { UniformBuffer, StorageBuffer, ReadOnlyStorageBuffer, Sampler, ComparisonSampler, Texture, DepthTexture, StorageTexture };
+
+    struct Binding {
+        uint32_t group = 0;
+        uint32_t binding = 0;
+        std::string name;
+        Type type;
+        BindingKind kind = BindingKind::UniformBuffer;
+        uint64_t size = 0;          // buffer：按 WGSL 布局规则算出的大小，运行时数组按 1 个元素计
+        uint32_t visibility = wgpu::ShaderStage::None;  // 用到它的入口所属的阶段
+    };
+
+    // 紧凑排布的顶点 buffer：各属性按声明顺序依次排列，只按格式要求的 min(4, size) 对齐
+    struct PackedVertexLayout {
+        struct Field {
+            std::string name;
+            uint32_t location = 0;
+            wgpu::VertexFormat format = wgpu::VertexFormat::Undefined;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+        std::string name;
+        std::vector<Field> fields;
+        std::vector<wgpu::VertexAttribute> attributes;
+        uint64_t stride = 0;
+        wgpu::VertexStepMode stepMode = wgpu::VertexStepMode::Vertex;
+
+        // 返回的布局指向本对象的 attributes，本对象需存活到 pipeline 创建完
+        wgpu::VertexBufferLayout GetLayout() const;
+        // 没有这个字段时返回 -1
+        int64_t OffsetOf(const std::string& fieldName) const;
+        // 与之对应的 C++ 结构体写法，便于核对/拷贝
+        std::string Describe() const;
+    };
+
+    // 解析失败时打印 行号 与原因并返回 false
+    bool Parse(const std::string& source);
+
+    const std::vector<EntryPoint>& GetEntryPoints() const { return entryPoints; }
+    const std::vector<Binding>& GetBindings() const { return bindings; }
+    const EntryPoint* FindEntryPoint(const std::string& name) const;
+
+    // group 的 BindGroupLayoutEntry，按 binding 排序；hasDynamicOffset 等 shader 里看不出来的由调用方再改
+    std::vector<wgpu::BindGroupLayoutEntry> GetBindGroupLayoutEntries(uint32_t group) const;
+    // formats 覆盖某些 location 的默认格式（例如 vec4f 的颜色用 Unorm8x4 存），其余按 WGSL 类型取 32 位格式
+    bool PackVertexInput(const VertexInput& input, wgpu::VertexStepMode stepMode, PackedVertexLayout& layout,
+                         const std::map<uint32_t, wgpu::VertexFormat>& formats = {}) const;
+
+    // WGSL 主机可共享类型的 对齐 / 大小
+    bool GetLayout(const Type& type, uint64_t& align, uint64_t& size) const;
+
+private:
+    struct Member {
+        std::string name;
+        Type type;
+        std::map<std::string, std::string> attributes;  // location -> "0"、align -> "16" ...
+    };
+    class Parser;
+    // 展开 alias 与 vec2f / mat4x4f 之类的简写
+    Type Resolve(const Type& type) const;
+
+private:
+    std::map<std::string, std::vector<Member>> structs;
+    std::map<std::string, Type> aliases;
+    std::vector<EntryPoint> entryPoints;
+    std::vector<Binding> bindings;
+};
@@ -0,0 +1,114 @@
+#include "upload-belt.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace {
+
+const uint64_t kCopyAlignment = 4; // copyBufferToBuffer 的 offset/size 对齐要求
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+
+UploadBelt::UploadBelt(wgpu::Device device, uint64_t chunkSize)
+    : device(device), chunkSize(AlignUp(chunkSize, kCopyAlignment)) {
+}
+
+UploadBelt::~UploadBelt() {
+    for (auto& chunk : chunks) {
+        chunk->buffer.destroy();
+    }
+    for (auto& chunk : chunks) {
+        chunk->buffer.release();
+    }
+}
+
+UploadBelt::Chunk* UploadBelt::CreateChunk(uint64_t size) {
+    wgpu::BufferDescriptor bufferDesc;
+    bufferDesc.label = "Upload belt chunk";
+    bufferDesc.size = size;
+    bufferDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+    bufferDesc.mappedAtCreation = true; // 一创建就处于映射状态，省掉第一次 mapAsync
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->buffer = device.createBuffer(bufferDesc);
+    chunk->size = size;
+    chunk->mapped = (uint8_t*)chunk->buffer.getMappedRange(0, size);
+    chunks.push_back(std::move(chunk));
+    return chunks.back().get();
+}
+
+UploadBelt::Chunk* UploadBelt::AcquireChunk(uint64_t size) {
+    for (Chunk* chunk : activeChunks) {
+        if (chunk->used + size <= chunk->size) {
+            return chunk;
+        }
+    }
+    Chunk* chunk = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        for (size_t i = 0; i < freeChunks.size(); ++i) {
+            if (freeChunks[i]->size >= size) {
+                chunk = freeChunks[i];
+                freeChunks.erase(freeChunks.begin() + i);
+                break;
+            }
+        }
+    }
+    if (chunk == nullptr) {
+        chunk = CreateChunk(std::max(chunkSize, size));
+    }
+    chunk->used = 0;
+    activeChunks.push_back(chunk);
+    return chunk;
+}
+
+void* UploadBelt::Write(wgpu::CommandEncoder encoder, wgpu::Buffer dst, uint64_t dstOffset, uint64_t size) {
+    assert(dstOffset % kCopyAlignment == 0 && size % kCopyAlignment == 0);
+    Chunk* chunk = AcquireChunk(size);
+    uint64_t offset = chunk->used;
+    chunk->used = AlignUp(offset + size, kCopyAlignment);
+    bytesWritten += size;
+
+    encoder.copyBufferToBuffer(chunk->buffer, offset, dst, dstOffset, size);
+    return chunk->mapped + offset;
+}
+
+void UploadBelt::Write(wgpu::CommandEncoder encoder, wgpu::Buffer dst, uint64_t dstOffset, const void* data, uint64_t size) {
+    std::memcpy(Write(encoder, dst, dstOffset, size), data, size);
+}
+
+void UploadBelt::Finish() {
+    // 被 submit 的命令引用的 buffer 不能处于映射状态
+    for (Chunk* chunk : activeChunks) {
+        chunk->buffer.unmap();
+        chunk->mapped = nullptr;
+        closedChunks.push_back(chunk);
+    }
+    activeChunks.clear();
+}
+
+void UploadBelt::Recall() {
+    // 回调可能在 ReadbackService 的 poll 线程上执行：回调整个在 freeMutex 下改 chunk，
+    // 这里也在锁下替换 mapHandle，旧的回调对象不会在执行到一半时被销毁
+    std::lock_guard<std::mutex> lock(freeMutex);
+    for (Chunk* chunk : closedChunks) {
+        // 复制命令已提交，mapAsync 会等 GPU 读完这个 chunk 之后才完成
+        chunk->mapHandle = chunk->buffer.mapAsync(wgpu::MapMode::Write, 0, chunk->size, [this, chunk](wgpu::BufferMapAsyncStatus status) {
+            if (status != wgpu::BufferMapAsyncStatus::Success) {
+                // 多半是 buffer 已经销毁（退出时），不再复用
+                return;
+            }
+            std::lock_guard<std::mutex> lock(freeMutex);
+            chunk->mapped = (uint8_t*)chunk->buffer.getMappedRange(0, chunk->size);
+            chunk->used = 0;
+            freeChunks.push_back(chunk);
+        });
+    }
+    closedChunks.clear();
+}
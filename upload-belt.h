@@ -0,0 +1,59 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+// 上传带（upload belt）：一圈 MapWrite | CopySrc 的暂存 chunk，代替 queue.writeBuffer。
+// writeBuffer 每次都要把数据再拷一遍到驱动内部的暂存区；这里调用方拿到的是映射内存的指针，直接往里写（不再多一次 memcpy），
+// 复制命令录制进调用方的 encoder 里批量提交，chunk 在 GPU 用完后通过 mapAsync 重新映射，回到空闲列表复用。
+//
+// 每一批的用法：
+//   void* p = belt.Write(encoder, dst, dstOffset, size);   // 可多次，写满 p
+//   belt.Finish();                                         // submit 之前：unmap 本批的 chunk
+//   queue.submit(...);
+//   belt.Recall();                                         // submit 之后：回收 chunk
+class UploadBelt {
+public:
+    // chunkSize : 每个暂存 chunk 的大小，超过它的单次写入会单独开一个同样大小的 chunk
+    UploadBelt(wgpu::Device device, uint64_t chunkSize);
+    ~UploadBelt();
+
+    UploadBelt(const UploadBelt&) = delete;
+    UploadBelt& operator=(const UploadBelt&) = delete;
+
+    // 录制 staging -> dst[dstOffset, dstOffset + size) 的复制，返回 size 字节的可写指针，Finish() 之前写完。
+    // dstOffset 与 size 需为 4 的倍数（copyBufferToBuffer 的要求）
+    void* Write(wgpu::CommandEncoder encoder, wgpu::Buffer dst, uint64_t dstOffset, uint64_t size);
+    // 已经有现成 CPU 数据时的便捷版本
+    void Write(wgpu::CommandEncoder encoder, wgpu::Buffer dst, uint64_t dstOffset, const void* data, uint64_t size);
+
+    void Finish();
+    void Recall();
+
+    uint32_t GetChunkCount() const { return static_cast<uint32_t>(chunks.size()); }
+    uint64_t GetBytesWritten() const { return bytesWritten; }
+
+private:
+    struct Chunk {
+        wgpu::Buffer buffer = nullptr;
+        uint64_t size = 0;
+        uint64_t used = 0;
+        uint8_t* mapped = nullptr;
+        std::unique_ptr<wgpu::BufferMapCallback> mapHandle;
+    };
+    Chunk* CreateChunk(uint64_t size);
+    Chunk* AcquireChunk(uint64_t size);
+
+private:
+    wgpu::Device device = nullptr;
+    uint64_t chunkSize = 0;
+    uint64_t bytesWritten = 0;
+
+    std::vector<std::unique_ptr<Chunk>> chunks; // 所有 chunk 的所有权
+    std::vector<Chunk*> activeChunks;           // 已映射，本批正在写
+    std::vector<Chunk*> closedChunks;           // 已 unmap，等本批 submit
+    std::mutex freeMutex;                       // map 回调可能在 poll 线程上执行
+    std::vector<Chunk*> freeChunks;             // 重新映射完成，可以复用
+};
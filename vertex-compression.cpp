@@ -0,0 +1,124 @@
+#include "vertex-compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void Store(uint8_t* target, const T* values, size_t count) {
+    std::memcpy(target, values, count * sizeof(T));
+}
+
+} // namespace
+
+
+wgpu::VertexFormat VertexEncoding::GetPositionFormat() const {
+    switch (position) {
+    case PositionEncoding::Snorm16:
+        return positionComponents == 2 ? wgpu::VertexFormat::Snorm16x2 : wgpu::VertexFormat::Snorm16x4;
+    case PositionEncoding::Unorm16:
+        return positionComponents == 2 ? wgpu::VertexFormat::Unorm16x2 : wgpu::VertexFormat::Unorm16x4;
+    case PositionEncoding::Float32:
+        break;
+    }
+    return positionComponents == 2 ? wgpu::VertexFormat::Float32x2 : wgpu::VertexFormat::Float32x3;
+}
+
+wgpu::VertexFormat VertexEncoding::GetColorFormat() const {
+    return color == ColorEncoding::Unorm8 ? wgpu::VertexFormat::Unorm8x4 : wgpu::VertexFormat::Float32x3;
+}
+
+uint32_t VertexEncoding::GetColorOffset() const {
+    if (position == PositionEncoding::Float32) {
+        return positionComponents * sizeof(float);
+    }
+    return (positionComponents == 2 ? 2 : 4) * sizeof(uint16_t);
+}
+
+uint32_t VertexEncoding::GetStride() const {
+    return GetColorOffset() + (color == ColorEncoding::Unorm8 ? 4 : 3 * sizeof(float));
+}
+
+
+CompressedVertices compressVertices(const Mesh& mesh, const VertexEncoding& encoding) {
+    CompressedVertices result;
+    result.encoding = encoding;
+    result.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    const uint32_t stride = encoding.GetStride();
+    const uint32_t colorOffset = encoding.GetColorOffset();
+    const uint32_t components = std::min(std::max(encoding.positionComponents, 2u), 3u);
+    result.data.assign(static_cast<size_t>(result.vertexCount) * stride, 0);
+
+    // 逐轴的包围盒决定量化区间；退化的轴（例如 2D 网格的 z）用 1 避免除 0
+    float lower[3] = { 0.0f, 0.0f, 0.0f };
+    float upper[3] = { 0.0f, 0.0f, 0.0f };
+    if (!mesh.vertices.empty()) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            lower[axis] = upper[axis] = mesh.vertices[0].position[axis];
+        }
+    }
+    for (const Mesh::Vertex& vertex : mesh.vertices) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            lower[axis] = std::min(lower[axis], vertex.position[axis]);
+            upper[axis] = std::max(upper[axis], vertex.position[axis]);
+        }
+    }
+    Dequantization& dequantization = result.dequantization;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        float extent = upper[axis] - lower[axis];
+        switch (encoding.position) {
+        case PositionEncoding::Snorm16:
+            // snorm16 解出来是 [-1, 1]，以包围盒中心为原点
+            dequantization.scale[axis] = extent > 0.0f ? 0.5f * extent : 1.0f;
+            dequantization.offset[axis] = 0.5f * (lower[axis] + upper[axis]);
+            break;
+        case PositionEncoding::Unorm16:
+            dequantization.scale[axis] = extent > 0.0f ? extent : 1.0f;
+            dequantization.offset[axis] = lower[axis];
+            break;
+        case PositionEncoding::Float32:
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < result.vertexCount; ++i) {
+        const Mesh::Vertex& vertex = mesh.vertices[i];
+        uint8_t* target = result.data.data() + static_cast<size_t>(i) * stride;
+
+        if (encoding.position == PositionEncoding::Float32) {
+            Store(target, vertex.position, components);
+        } else {
+            bool isSigned = encoding.position == PositionEncoding::Snorm16;
+            uint16_t quantized[4] = { 0, 0, 0, 0 };
+            for (uint32_t axis = 0; axis < components; ++axis) {
+                float normalized = (vertex.position[axis] - dequantization.offset[axis]) / dequantization.scale[axis];
+                float decoded = 0.0f;
+                if (isSigned) {
+                    // 只用 [-32767, 32767]，-32768 与 -32767 解出来都是 -1
+                    int16_t q = static_cast<int16_t>(std::lround(std::min(std::max(normalized, -1.0f), 1.0f) * 32767.0f));
+                    std::memcpy(&quantized[axis], &q, sizeof(q));
+                    decoded = static_cast<float>(q) / 32767.0f;
+                } else {
+                    quantized[axis] = static_cast<uint16_t>(std::lround(std::min(std::max(normalized, 0.0f), 1.0f) * 65535.0f));
+                    decoded = static_cast<float>(quantized[axis]) / 65535.0f;
+                }
+                float error = std::fabs(decoded * dequantization.scale[axis] + dequantization.offset[axis] - vertex.position[axis]);
+                result.maxPositionError = std::max(result.maxPositionError, error);
+            }
+            Store(target, quantized, components == 2 ? 2 : 4);
+        }
+
+        if (encoding.color == ColorEncoding::Unorm8) {
+            uint8_t color[4] = { 0, 0, 0, 255 };
+            for (uint32_t c = 0; c < 3; ++c) {
+                color[c] = static_cast<uint8_t>(std::lround(std::min(std::max(vertex.color[c], 0.0f), 1.0f) * 255.0f));
+            }
+            Store(target + colorOffset, color, 4);
+        } else {
+            Store(target + colorOffset, vertex.color, 3);
+        }
+    }
+    return result;
+}
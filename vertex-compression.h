@@ -0,0 +1,40 @@
+#pragma once
+#include <webgpu/webgpu.hpp>
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// 顶点压缩：位置量化成 16 位定点（snorm16 / unorm16），颜色存成 unorm8x4，
+// 5 个 float（20 字节）的顶点变成 8 字节，上传量与顶点读取带宽都少一大半。
+// 位置按网格的包围盒逐轴量化，shader 里用 Dequantization 还原：position = q * scale + offset。
+enum class PositionEncoding { Float32, Snorm16, Unorm16 };
+enum class ColorEncoding { Float32, Unorm8 };
+
+struct VertexEncoding {
+    PositionEncoding position = PositionEncoding::Snorm16;
+    ColorEncoding color = ColorEncoding::Unorm8;
+    uint32_t positionComponents = 2;    // 2：只存 xy（本例是 2D），3：xyz（16 位格式没有 x3，补成 x4）
+
+    // 顶点布局：位置在前，颜色紧随其后
+    wgpu::VertexFormat GetPositionFormat() const;
+    wgpu::VertexFormat GetColorFormat() const;
+    uint32_t GetColorOffset() const;
+    uint32_t GetStride() const;
+};
+
+struct Dequantization {
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+struct CompressedVertices {
+    VertexEncoding encoding;
+    Dequantization dequantization;
+    std::vector<uint8_t> data;      // vertexCount * encoding.GetStride() 字节
+    uint32_t vertexCount = 0;
+    float maxPositionError = 0.0f;  // 量化后还原出来的位置与原值的最大偏差
+};
+
+CompressedVertices compressVertices(const Mesh& mesh, const VertexEncoding& encoding);
@@ -3,6 +3,11 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <atomic>
+
+#ifdef __EMSCRIPTEN__
+#  include <emscripten.h>
+#endif // __EMSCRIPTEN__
 
 
 void inspectAdapter(wgpu::Adapter adapter) {
@@ -104,4 +109,36 @@ void inspectDevice(wgpu::Device device) {
 		std::cout << " - maxComputeWorkgroupSizeZ: " << limits.limits.maxComputeWorkgroupSizeZ << std::endl;
 		std::cout << " - maxComputeWorkgroupsPerDimension: " << limits.limits.maxComputeWorkgroupsPerDimension << std::endl;
 	}
-}
\ No newline at end of file
+}
+
+
+
+void waitForQueueIdle(wgpu::Device device, wgpu::Queue queue) {
+    // 有 ReadbackService 的 poll 线程时，回调可能在那个线程上执行
+    std::atomic<bool> done{ false };
+    // 返回值必须持有，否则回调对象被回收，永远等不到 done
+    auto handle = queue.onSubmittedWorkDone([&done](wgpu::QueueWorkDoneStatus status) {
+        if (status != wgpu::QueueWorkDoneStatus::Success) {
+            std::cout << "Queue work done with status " << status << std::endl;
+        }
+        done = true;
+    });
+    while (!done) {
+#if defined(WEBGPU_BACKEND_DAWN)
+        device.tick();
+#elif defined(WEBGPU_BACKEND_WGPU)
+        device.poll(true); // wait = true : 阻塞到已提交的工作完成，不空转
+#elif defined(__EMSCRIPTEN__)
+        emscripten_sleep(1); // 需要 -sASYNCIFY，把控制权交还给浏览器
+#endif
+    }
+}
+
+uint64_t hashFnv1a(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
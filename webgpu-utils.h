@@ -3,4 +3,10 @@
 
 void inspectAdapter(wgpu::Adapter adapter);
 
-void inspectDevice(wgpu::Device device);
\ No newline at end of file
+void inspectDevice(wgpu::Device device);
+
+// 阻塞直到 queue 里已提交的工作全部在 GPU 上执行完（onSubmittedWorkDone + poll）
+void waitForQueueIdle(wgpu::Device device, wgpu::Queue queue);
+
+// FNV-1a 64 位哈希；传入上一次的结果可以分段累加
+uint64_t hashFnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
@@ -0,0 +1,77 @@
+#include "worker-pool.h"
+
+WorkerPool::WorkerPool(uint32_t threadCount) {
+#ifndef __EMSCRIPTEN__
+    if (threadCount == 0) {
+        uint32_t hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 0;
+    }
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkerPool::WorkerThread, this);
+    }
+#else
+    (void)threadCount;
+#endif
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (threads.empty() || count == 1) {
+        for (uint32_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        taskCount = count;
+        nextTask.store(0);
+        busyThreads = static_cast<uint32_t>(threads.size());
+        ++generation;
+    }
+    wakeUp.notify_all();
+    RunTasks();
+
+    // task 引用的是调用方的对象，等所有后台线程都离开 RunTasks 才能返回
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return busyThreads == 0; });
+    this->task = nullptr;
+}
+
+void WorkerPool::RunTasks() {
+    for (uint32_t i = nextTask.fetch_add(1); i < taskCount; i = nextTask.fetch_add(1)) {
+        (*task)(i);
+    }
+}
+
+void WorkerPool::WorkerThread() {
+    uint64_t seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        lock.unlock();
+        RunTasks();
+        lock.lock();
+        if (--busyThreads == 0) {
+            finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定数量的后台线程，用于把可拆分的 CPU 工作（解析、解码 ...）摊到多个核上。
+// ParallelFor 时调用线程也参与干活；emscripten 下（没开 pthreads）线程数为 0，全部在调用线程上顺序执行。
+class WorkerPool {
+public:
+    // threadCount 为后台线程数，0 表示 hardware_concurrency - 1
+    explicit WorkerPool(uint32_t threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 参与 ParallelFor 的线程数（含调用线程），用来决定切多少块
+    uint32_t GetConcurrency() const { return static_cast<uint32_t>(threads.size()) + 1; }
+
+    // 对 [0, count) 的每个 i 调用一次 task(i)，全部完成后返回。同一时间只能有一个 ParallelFor，task 里不要再调用它
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+private:
+    void WorkerThread();
+    void RunTasks();
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wakeUp;     // 有新一轮 ParallelFor / 要退出
+    std::condition_variable finished;   // 后台线程做完了这一轮
+    const std::function<void(uint32_t)>* task = nullptr;
+    uint32_t taskCount = 0;
+    std::atomic<uint32_t> nextTask{ 0 };
+    uint32_t busyThreads = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};